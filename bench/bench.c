@@ -0,0 +1,358 @@
+#include "curve.h"
+#include "curve_print.h"
+#include "point.h"
+#include "rdp_kernel.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Benchmarks the C implementation over a sweep of input sizes and curve
+ * shapes and writes the timings as JSON. Run with --help for the options.
+ * The shapes and benchmark names match bench.cpp. The C curve has no
+ * sortPoints, addPointSorted or compressed encoding so those benchmarks only
+ * exist there.
+ */
+
+#define MAX_RUNS 1000
+#define SHAPE_COUNT 5
+#define EPSILON_COUNT 3
+#define BENCHMARK_COUNT 9
+
+static char const *const shapes[SHAPE_COUNT] = {"smooth", "random_walk",
+                                                "noisy_sine", "spiral", "line"};
+static double const epsilons[EPSILON_COUNT] = {0.001, 0.01, 0.1};
+
+/* printing is only ever done for screen sized curves so it stops early */
+static long const print_limit = 10000000;
+
+struct options {
+  long min_size, max_size;
+  /* each measurement repeats until it has run for this long */
+  double min_time;
+  /* a benchmark is not run at the next size once one run takes longer than
+   * a tenth of this, since it would take about this long */
+  double budget;
+  char const *output;
+};
+
+struct result {
+  char const *benchmark;
+  char const *shape;
+  long size;
+  double epsilon;
+  int iterations;
+  double min_ns, median_ns;
+};
+
+struct results {
+  struct result *data;
+  int length, capacity;
+};
+
+/* what a benchmark runs on, filled in by the caller of measure */
+struct bench_input {
+  curve *c;
+  double epsilon;
+  double delta;
+};
+
+typedef void (*bench_fn)(struct bench_input *in);
+
+static double smooth(double x) { return exp(-x) * cos(2 * M_PI * x); }
+
+/* xorshift so the inputs are the same on every platform */
+static uint64_t rng_state = 42;
+
+static double uniform(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double normal(void) {
+  double u = uniform();
+  double v = uniform();
+  return sqrt(-2 * log(u + 1e-300)) * cos(2 * M_PI * v);
+}
+
+/*
+ * Fills _points_ with _n_ points of _shape_. Spirals make rdp split into very
+ * deep trees and straight lines never split at all.
+ */
+static void make_shape(char const *shape, long n, point *points) {
+  double step = n > 1 ? 10.0 / (n - 1) : 0;
+
+  if (strcmp(shape, "smooth") == 0) {
+    for (long i = 0; i < n; i++) {
+      points[i].x = i * step;
+      points[i].y = smooth(i * step);
+    }
+  } else if (strcmp(shape, "random_walk") == 0) {
+    double y = 0;
+    for (long i = 0; i < n; i++) {
+      points[i].x = (double)i;
+      points[i].y = y;
+      y += normal();
+    }
+  } else if (strcmp(shape, "noisy_sine") == 0) {
+    for (long i = 0; i < n; i++) {
+      points[i].x = i * step;
+      points[i].y = sin(i * step) + 0.1 * normal();
+    }
+  } else if (strcmp(shape, "spiral") == 0) {
+    double turns = fmax(1.0, sqrt((double)n) / 4);
+    for (long i = 0; i < n; i++) {
+      double t = (double)i / n;
+      double angle = 2 * M_PI * turns * t;
+      points[i].x = t * cos(angle);
+      points[i].y = t * sin(angle);
+    }
+  } else {
+    for (long i = 0; i < n; i++) {
+      points[i].x = i * step;
+      points[i].y = 2 * i * step + 1;
+    }
+  }
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(void const *a, void const *b) {
+  double x = *(double const *)a;
+  double y = *(double const *)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Runs _fn_ until at least _min_time_ seconds have passed and stores the
+ * fastest and median run in _r_
+ */
+static void measure(double min_time, bench_fn fn, struct bench_input *in,
+                    struct result *r) {
+  static double runs[MAX_RUNS];
+  int count = 0;
+  double total = 0;
+  while ((total < min_time || count == 0) && count < MAX_RUNS) {
+    double start = now_ns();
+    fn(in);
+    runs[count] = now_ns() - start;
+    total += runs[count++] * 1e-9;
+  }
+  qsort(runs, count, sizeof(*runs), compare_doubles);
+  r->iterations = count;
+  r->min_ns = runs[0];
+  r->median_ns = runs[count / 2];
+}
+
+static void bench_construct(struct bench_input *in) {
+  curve *c = curve_construct(0, 10, in->delta, smooth);
+  curve_construct_free(c);
+}
+
+static void bench_adaptive(struct bench_input *in) {
+  curve *c = curve_adaptive(0, 10, in->delta, in->epsilon, smooth, 16);
+  rdp_result_free(c);
+}
+
+static void bench_furthest_point(struct bench_input *in) {
+  double distance;
+  volatile int index = furthestPoint(in->c, 0, in->c->length - 1, &distance);
+  (void)index;
+}
+
+static void bench_rdp(struct bench_input *in) {
+  curve *r = rdp(in->c, in->epsilon);
+  rdp_result_free(r);
+}
+
+/* a triangle with a base of 1 and a height of epsilon, so the two
+ * simplifiers see comparable tolerances */
+static void bench_visvalingam(struct bench_input *in) {
+  curve *r = visvalingam(in->c, in->epsilon / 2);
+  rdp_result_free(r);
+}
+
+static void bench_radial_distance(struct bench_input *in) {
+  curve *r = radial_distance(in->c, in->epsilon);
+  rdp_result_free(r);
+}
+
+static void bench_reumann_witkam(struct bench_input *in) {
+  curve *r = reumann_witkam(in->c, in->epsilon);
+  rdp_result_free(r);
+}
+
+static void bench_rdp_prefiltered(struct bench_input *in) {
+  curve *r = rdp_prefiltered(in->c, in->epsilon, in->epsilon / 2);
+  rdp_result_free(r);
+}
+
+static void bench_print(struct bench_input *in) { curve_print(in->c, NULL); }
+
+static void push_result(struct results *results, struct result r) {
+  if (results->length == results->capacity) {
+    results->capacity = results->capacity == 0 ? 64 : results->capacity * 2;
+    results->data =
+        realloc(results->data, sizeof(*results->data) * results->capacity);
+    if (results->data == NULL) {
+      fprintf(stderr, "Out of memory!");
+      abort();
+    }
+  }
+  results->data[results->length++] = r;
+}
+
+static void write_json(FILE *out, struct results const *results) {
+  fprintf(out, "{\n  \"implementation\": \"c\",\n");
+  fprintf(out, "  \"isa\": \"%s\",\n",
+          rdp_kernel_isa_name(rdp_kernel_get_isa()));
+  fprintf(out, "  \"results\": [");
+  for (int i = 0; i < results->length; i++) {
+    struct result const *r = &results->data[i];
+    fprintf(out,
+            "%s\n    {\"benchmark\": \"%s\", \"shape\": \"%s\", "
+            "\"size\": %ld, \"epsilon\": %g, \"iterations\": %d, "
+            "\"min_ns\": %.0f, \"median_ns\": %.0f, "
+            "\"points_per_second\": %.6g}",
+            i == 0 ? "" : ",", r->benchmark, r->shape, r->size, r->epsilon,
+            r->iterations, r->min_ns, r->median_ns,
+            r->size / (r->median_ns * 1e-9));
+  }
+  fprintf(out, "\n  ]\n}\n");
+}
+
+static bool parse_args(int argc, char const *argv[], struct options *opts) {
+  for (int i = 1; i < argc; i++) {
+    bool has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--min-size") == 0 && has_value)
+      opts->min_size = atol(argv[++i]);
+    else if (strcmp(argv[i], "--max-size") == 0 && has_value)
+      opts->max_size = atol(argv[++i]);
+    else if (strcmp(argv[i], "--min-time") == 0 && has_value)
+      opts->min_time = atof(argv[++i]);
+    else if (strcmp(argv[i], "--budget") == 0 && has_value)
+      opts->budget = atof(argv[++i]);
+    else if (strcmp(argv[i], "--output") == 0 && has_value)
+      opts->output = argv[++i];
+    else
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char const *argv[]) {
+  struct options opts = {1000, 100000000, 0.2, 30, NULL};
+  if (!parse_args(argc, argv, &opts)) {
+    fprintf(stderr,
+            "usage: %s [--min-size N] [--max-size N] [--min-time SEC] "
+            "[--budget SEC] [--output FILE]\n",
+            argv[0]);
+    return 1;
+  }
+
+  FILE *out = stdout;
+  if (opts.output != NULL) {
+    out = fopen(opts.output, "w");
+    if (out == NULL) {
+      perror(opts.output);
+      return 1;
+    }
+  }
+
+  /* curve_print writes to stdout at the size of the terminal, so stdout is
+   * sent nowhere while benchmarking and the screen is fixed at 80x24 */
+  setenv("LINES", "24", 1);
+  setenv("COLUMNS", "80", 1);
+  fflush(stdout);
+  int saved_stdout = dup(STDOUT_FILENO);
+  int null_fd = open("/dev/null", O_WRONLY);
+  if (saved_stdout == -1 || null_fd == -1) {
+    perror("redirecting stdout");
+    return 1;
+  }
+  dup2(null_fd, STDOUT_FILENO);
+  close(null_fd);
+
+  struct results results = {NULL, 0, 0};
+  /* indexed by benchmark, shape and epsilon */
+  bool too_slow[BENCHMARK_COUNT][SHAPE_COUNT][EPSILON_COUNT] = {{{false}}};
+
+  for (long n = opts.min_size; n <= opts.max_size; n *= 10) {
+    point *points = malloc(sizeof(*points) * n);
+    if (points == NULL) {
+      fprintf(stderr, "Out of memory!");
+      abort();
+    }
+
+    for (int s = -1; s < SHAPE_COUNT; s++) {
+      struct bench_input in = {NULL, 0, 10.0 / (n - 1)};
+      curve c = {(int)n, points};
+      if (s >= 0) {
+        make_shape(shapes[s], n, points);
+        in.c = &c;
+      }
+
+      /* construct and adaptive only depend on the size so they run once per
+       * size */
+      struct {
+        char const *name;
+        bench_fn fn;
+        bool per_epsilon, enabled;
+      } const benchmarks[] = {
+          {"construct", bench_construct, false, s == -1},
+          {"adaptive", bench_adaptive, true, s == -1},
+          {"furthestPoint", bench_furthest_point, false, s >= 0},
+          {"rdp", bench_rdp, true, s >= 0},
+          {"visvalingam", bench_visvalingam, true, s >= 0},
+          {"radial_distance", bench_radial_distance, true, s >= 0},
+          {"reumann_witkam", bench_reumann_witkam, true, s >= 0},
+          {"rdp_prefiltered", bench_rdp_prefiltered, true, s >= 0},
+          {"print", bench_print, false, s >= 0 && n <= print_limit},
+      };
+
+      for (int b = 0; b < BENCHMARK_COUNT; b++) {
+        if (!benchmarks[b].enabled)
+          continue;
+        int epsilon_count = benchmarks[b].per_epsilon ? EPSILON_COUNT : 1;
+        for (int e = 0; e < epsilon_count; e++) {
+          bool *slow = &too_slow[b][s < 0 ? 0 : s][e];
+          if (*slow)
+            continue;
+
+          in.epsilon = benchmarks[b].per_epsilon ? epsilons[e] : 0;
+          struct result r = {benchmarks[b].name, s < 0 ? "smooth" : shapes[s],
+                             n, in.epsilon, 0, 0, 0};
+          measure(opts.min_time, benchmarks[b].fn, &in, &r);
+          push_result(&results, r);
+          fprintf(stderr, "%-16s %-12s %10ld %8g %14.0f ns\n", r.benchmark,
+                  r.shape, n, r.epsilon, r.median_ns);
+          if (r.min_ns * 1e-9 * 10 > opts.budget)
+            *slow = true;
+        }
+      }
+    }
+    free(points);
+  }
+
+  fflush(stdout);
+  dup2(saved_stdout, STDOUT_FILENO);
+  close(saved_stdout);
+
+  write_json(out, &results);
+  if (out != stdout)
+    fclose(out);
+  free(results.data);
+  return 0;
+}
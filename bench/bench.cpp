@@ -0,0 +1,307 @@
+#include "curve.hpp"
+#include "curve_codec.hpp"
+#include "curve_print.hpp"
+#include "point.hpp"
+#include "rdp_kernel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/*
+ * Benchmarks the C++ implementation over a sweep of input sizes and curve
+ * shapes and writes the timings as JSON. Run with --help for the options.
+ * bench.c does the same for the C implementation with the same shapes, so
+ * the two outputs can be compared entry by entry.
+ */
+
+namespace {
+
+struct options {
+  long minSize = 1000;
+  long maxSize = 100000000;
+  // each measurement repeats until it has run for this long
+  double minTime = 0.2;
+  // a benchmark is not run at the next size once one run takes longer than
+  // a tenth of this, since it would take about this long
+  double budget = 30;
+  char const *output = nullptr;
+};
+
+struct result {
+  std::string benchmark;
+  std::string shape;
+  long size;
+  double epsilon;
+  int iterations;
+  double minNs;
+  double medianNs;
+};
+
+using points_t = std::vector<point<double>>;
+
+double smooth(double x) { return std::exp(-x) * std::cos(2 * M_PI * x); }
+
+/*
+ * The inputs every benchmark runs over. Spirals make RDP split into very
+ * deep trees and straight lines never split at all.
+ */
+points_t make_shape(std::string const &shape, long n, std::mt19937_64 &rng) {
+  points_t points;
+  points.reserve(n);
+  std::normal_distribution<double> noise(0, 1);
+  double step = n > 1 ? 10.0 / (n - 1) : 0;
+
+  if (shape == "smooth") {
+    for (long i = 0; i < n; i++)
+      points.emplace_back(i * step, smooth(i * step));
+  } else if (shape == "random_walk") {
+    double y = 0;
+    for (long i = 0; i < n; i++) {
+      points.emplace_back(static_cast<double>(i), y);
+      y += noise(rng);
+    }
+  } else if (shape == "noisy_sine") {
+    for (long i = 0; i < n; i++)
+      points.emplace_back(i * step, std::sin(i * step) + 0.1 * noise(rng));
+  } else if (shape == "spiral") {
+    double turns = std::max(1.0, std::sqrt(static_cast<double>(n)) / 4);
+    for (long i = 0; i < n; i++) {
+      double t = static_cast<double>(i) / n;
+      double angle = 2 * M_PI * turns * t;
+      points.emplace_back(t * std::cos(angle), t * std::sin(angle));
+    }
+  } else {
+    for (long i = 0; i < n; i++)
+      points.emplace_back(i * step, 2 * i * step + 1);
+  }
+  return points;
+}
+
+/*
+ * Runs _body_ until at least _minTime_ seconds have passed and returns the
+ * fastest and median run. _setup_ runs before each run and is not timed.
+ */
+void measure(double minTime, std::function<void()> const &setup,
+             std::function<void()> const &body, result &r) {
+  using clock = std::chrono::steady_clock;
+  std::vector<double> runs;
+  double total = 0;
+  while (total < minTime || runs.empty()) {
+    setup();
+    auto start = clock::now();
+    body();
+    double ns = std::chrono::duration<double, std::nano>(clock::now() - start)
+                    .count();
+    runs.push_back(ns);
+    total += ns * 1e-9;
+    if (runs.size() >= 1000)
+      break;
+  }
+  std::sort(runs.begin(), runs.end());
+  r.iterations = static_cast<int>(runs.size());
+  r.minNs = runs.front();
+  r.medianNs = runs[runs.size() / 2];
+}
+
+class null_buffer : public std::streambuf {
+protected:
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+  std::streamsize xsputn(char const *, std::streamsize n) override {
+    return n;
+  }
+};
+
+void write_json(std::FILE *out, std::vector<result> const &results) {
+  std::fprintf(out, "{\n  \"implementation\": \"c++\",\n");
+  std::fprintf(out, "  \"isa\": \"%s\",\n",
+               rdp_kernel_isa_name(rdp_kernel_get_isa()));
+  std::fprintf(out, "  \"results\": [");
+  for (std::size_t i = 0; i < results.size(); i++) {
+    auto const &r = results[i];
+    std::fprintf(out,
+                 "%s\n    {\"benchmark\": \"%s\", \"shape\": \"%s\", "
+                 "\"size\": %ld, \"epsilon\": %g, \"iterations\": %d, "
+                 "\"min_ns\": %.0f, \"median_ns\": %.0f, "
+                 "\"points_per_second\": %.6g}",
+                 i == 0 ? "" : ",", r.benchmark.c_str(), r.shape.c_str(),
+                 r.size, r.epsilon, r.iterations, r.minNs, r.medianNs,
+                 r.size / (r.medianNs * 1e-9));
+  }
+  std::fprintf(out, "\n  ]\n}\n");
+}
+
+bool parse_args(int argc, char const *argv[], options &opts) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--min-size" && hasValue)
+      opts.minSize = std::atol(argv[++i]);
+    else if (arg == "--max-size" && hasValue)
+      opts.maxSize = std::atol(argv[++i]);
+    else if (arg == "--min-time" && hasValue)
+      opts.minTime = std::atof(argv[++i]);
+    else if (arg == "--budget" && hasValue)
+      opts.budget = std::atof(argv[++i]);
+    else if (arg == "--output" && hasValue)
+      opts.output = argv[++i];
+    else
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char const *argv[]) {
+  options opts;
+  if (!parse_args(argc, argv, opts)) {
+    std::fprintf(stderr,
+                 "usage: %s [--min-size N] [--max-size N] [--min-time SEC] "
+                 "[--budget SEC] [--output FILE]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  std::vector<std::string> const shapes = {"smooth", "random_walk",
+                                           "noisy_sine", "spiral", "line"};
+  std::vector<double> const epsilons = {0.001, 0.01, 0.1};
+  // inserting one point at a time is quadratic and printing is only ever
+  // done for screen sized curves, so both stop early
+  long const addPointSortedLimit = 100000;
+  long const printLimit = 10000000;
+
+  null_buffer sink;
+  std::ostream nowhere(&sink);
+  curve_print printer(false, false, false, true, 80, 24, nowhere);
+
+  std::vector<result> results;
+  std::map<std::string, bool> tooSlow;
+  std::mt19937_64 rng(42);
+
+  // runs one measurement unless a smaller size already took too long
+  auto run = [&](std::string const &benchmark, std::string const &shape,
+                 long n, double epsilon, std::function<void()> const &setup,
+                 std::function<void()> const &body) {
+    std::string key = benchmark + "/" + shape + "/" + std::to_string(epsilon);
+    if (tooSlow[key])
+      return;
+    result r{benchmark, shape, n, epsilon, 0, 0, 0};
+    measure(opts.minTime, setup, body, r);
+    results.push_back(r);
+    std::fprintf(stderr, "%-16s %-12s %10ld %8g %14.0f ns\n", benchmark.c_str(),
+                 shape.c_str(), n, epsilon, r.medianNs);
+    if (r.minNs * 1e-9 * 10 > opts.budget)
+      tooSlow[key] = true;
+  };
+  auto none = [] {};
+
+  for (long n = opts.minSize; n <= opts.maxSize; n *= 10) {
+    double delta = 10.0 / (n - 1);
+    run("construct", "smooth", n, 0, none, [&] {
+      auto c = curve<>::construct(0.0, 10.0, delta, smooth);
+      (void)c;
+    });
+    for (double epsilon : epsilons) {
+      run("adaptive", "smooth", n, epsilon, none, [&] {
+        auto c = curve<>::adaptive(0.0, 10.0, delta, epsilon, smooth);
+        (void)c;
+      });
+    }
+
+    for (auto const &shape : shapes) {
+      curve<double> c{make_shape(shape, n, rng)};
+      int last = static_cast<int>(c.length()) - 1;
+
+      run("furthestPoint", shape, n, 0, none, [&] {
+        auto [index, distance] = c.furthestPoint(0, last);
+        (void)index;
+        (void)distance;
+      });
+
+      for (double epsilon : epsilons) {
+        run("rdp", shape, n, epsilon, none, [&] {
+          auto r = c.simplify(rdp_simplifier{epsilon});
+          (void)r;
+        });
+        // a triangle with a base of 1 and a height of epsilon, so the two
+        // simplifiers see comparable tolerances
+        run("visvalingam", shape, n, epsilon, none, [&] {
+          auto r = c.simplify(visvalingam_simplifier{epsilon / 2});
+          (void)r;
+        });
+        run("radial_distance", shape, n, epsilon, none, [&] {
+          auto r = c.radial_distance(epsilon);
+          (void)r;
+        });
+        run("reumann_witkam", shape, n, epsilon, none, [&] {
+          auto r = c.reumann_witkam(epsilon);
+          (void)r;
+        });
+        run("rdp_prefiltered", shape, n, epsilon, none, [&] {
+          auto r = c.rdp_prefiltered(epsilon, epsilon / 2);
+          (void)r;
+        });
+      }
+
+      points_t shuffled = c.points();
+      std::shuffle(shuffled.begin(), shuffled.end(), rng);
+      curve<double> unsorted;
+      run(
+          "sortPoints", shape, n, 0,
+          [&] { unsorted = curve<double>{shuffled}; },
+          [&] { unsorted.sortPoints(); });
+      unsorted = curve<double>{};
+
+      if (n <= addPointSortedLimit) {
+        run("addPointSorted", shape, n, 0, none, [&] {
+          curve<double> built;
+          for (auto const &p : shuffled)
+            built.addPointSorted(p);
+        });
+      }
+
+      std::vector<std::uint8_t> encoded;
+      run("encode", shape, n, 0, none, [&] { encoded = encode_curve(c); });
+      run("decode", shape, n, 0, none, [&] {
+        std::size_t decoded = curve_decoder<double>(encoded).read(
+            [](std::span<point<double> const>) {});
+        (void)decoded;
+      });
+      encoded = {};
+
+      if (n <= printLimit)
+        run("print", shape, n, 0, none, [&] { printer.print(c); });
+      run("m4", shape, n, 0, none, [&] {
+        auto d = printer.decimate(c);
+        (void)d;
+      });
+      run("lttb", shape, n, 0, none, [&] {
+        auto d = printer.decimate_lttb(c);
+        (void)d;
+      });
+    }
+  }
+
+  std::FILE *out = stdout;
+  if (opts.output != nullptr) {
+    out = std::fopen(opts.output, "w");
+    if (out == nullptr) {
+      std::perror(opts.output);
+      return 1;
+    }
+  }
+  write_json(out, results);
+  if (out != stdout)
+    std::fclose(out);
+  return 0;
+}
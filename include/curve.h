@@ -1,8 +1,12 @@
 #ifndef CURVE_H
 #define CURVE_H
 
+#include "curve_file.h"
 #include "math.h"
 #include "point.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 typedef struct {
   int length;
@@ -16,16 +20,201 @@ typedef struct {
  */
 int furthestPoint(curve const *inCurve, int start, int end, double *distance);
 
+/**
+ * Makes furthestPoint split scans over at least _min_length_ points into
+ * _threads_ chunks that run on their own threads. The chunk results are
+ * combined so the answer is the same as a serial scan. Passing _threads_ <= 1
+ * turns this off, which is the default.
+ *
+ * This affects every later call to furthestPoint and rdp, so call it before
+ * starting any threads that use them.
+ */
+void rdp_set_parallel_scan(int threads, int min_length);
+
+/**
+ * Makes curve_construct, curve_from_quadratic and curve_from_line evaluate
+ * curves of at least _min_length_ points in _threads_ chunks that run on
+ * their own threads. The points are the same as when built serially. Passing
+ * _threads_ <= 1 turns this off, which is the default.
+ *
+ * This affects every later call to them, so call it before starting any
+ * threads that use them.
+ */
+void curve_set_parallel_construct(int threads, int min_length);
+
 /**
  * Caller must free return value using rdp_result_free
  */
 curve *rdp(curve const *start, double epsilon);
 
+/**
+ * Caller must free return value using rdp_result_free
+ * Simplifies _start_ with the Visvalingam-Whyatt algorithm: the point making
+ * the smallest triangle with its neighbours is removed until every remaining
+ * triangle has an area of at least _area_.
+ */
+curve *visvalingam(curve const *start, double area);
+
+/**
+ * Caller must free return value using rdp_result_free
+ * Simplifies _start_ to _count_ points, or to its two endpoints if _count_ is
+ * smaller, with the Visvalingam-Whyatt algorithm. If _area_ is not NULL it is
+ * set to the largest triangle area that was removed.
+ */
+curve *visvalingam_to_count(curve const *start, int count, double *area);
+
+/**
+ * Caller must free return value using rdp_result_free
+ * Keeps the first and last points of _start_ and every point at least
+ * _tolerance_ from the point kept before it, in one pass. Every dropped
+ * point is within _tolerance_ of a kept point.
+ */
+curve *radial_distance(curve const *start, double tolerance);
+
+/**
+ * Caller must free return value using rdp_result_free
+ * Simplifies _start_ in one pass with the Reumann-Witkam algorithm using a
+ * strip _tolerance_ wide. Points are dropped while they stay in the strip
+ * around the line from the last kept point and move forward along it, so
+ * every dropped point is less than _tolerance_ from the segment between
+ * the kept points around it.
+ */
+curve *reumann_witkam(curve const *start, double tolerance);
+
+/**
+ * Caller must free return value using rdp_result_free
+ * Same as rdp(start, epsilon), in that every dropped point is within
+ * _epsilon_ of the result, but most of the points of an oversampled curve
+ * are first dropped by reumann_witkam at _tolerance_ and rdp only runs on
+ * the rest at epsilon - tolerance. The two bounds add up because rdp keeps
+ * every segment of the filtered curve within its epsilon of the result.
+ * Returns NULL unless 0 <= tolerance < epsilon.
+ */
+curve *rdp_prefiltered(curve const *start, double epsilon, double tolerance);
+
+/**
+ * A simplification algorithm taking its tolerance as the second argument.
+ * rdp, visvalingam, radial_distance and reumann_witkam all fit, so code
+ * that takes a curve_simplifier can run any of them on the same inputs or
+ * chain a filter in front of rdp.
+ */
+typedef curve *(*curve_simplifier)(curve const *, double);
+
+/**
+ * A pending range of the curve on the rdp stack. When emit_start is set the
+ * start point was kept by the split that created the range.
+ */
+struct rdp_span {
+  int start, end;
+  bool emit_start;
+};
+
+/**
+ * Buffers used by rdp_with_workspace between calls. Reusing a workspace for
+ * repeated simplifications means nothing is allocated once the buffers have
+ * grown to fit the largest input.
+ *
+ * Initialize with rdp_workspace_init and release with rdp_workspace_free
+ */
+struct rdp_workspace {
+  struct rdp_span *stack;
+  int stack_capacity;
+  int *indices;
+  int indices_capacity;
+  int length;
+  point *points;
+  int points_capacity;
+};
+
+void rdp_workspace_init(struct rdp_workspace *ws);
+void rdp_workspace_free(struct rdp_workspace *ws);
+
+/**
+ * Runs rdp on _start_ but only stores the indices of the kept points, in
+ * ascending order, in ws->indices.
+ *
+ * returns: the number of kept points, which is also stored in ws->length
+ */
+int rdp_indices(curve const *start, double epsilon, struct rdp_workspace *ws);
+
+/**
+ * Same as rdp but uses the buffers in _ws_. The returned curve points into
+ * _ws_ and is only valid until _ws_ is used again or freed. It must not be
+ * passed to rdp_result_free. The indices of the kept points are available in
+ * ws->indices.
+ */
+curve rdp_with_workspace(curve const *start, double epsilon,
+                         struct rdp_workspace *ws);
+
+/**
+ * What one call to rdp_with_stats did. max_depth is the most ranges that
+ * were pending at once, which is the recursion depth a recursive
+ * implementation would reach, and bytes_allocated is how much the working
+ * buffers grew to.
+ */
+struct rdp_stats {
+  uint64_t distance_evaluations;
+  uint64_t segments;
+  int kept;
+  int max_depth;
+  size_t bytes_allocated;
+  /* wall time finding the points to keep and copying them out */
+  uint64_t split_ns, gather_ns;
+};
+
+/**
+ * Same as rdp but fills in _stats_. The counting is compiled into this
+ * function only, so rdp and rdp_with_workspace are not slowed down by it.
+ * Caller must free return value using rdp_result_free
+ */
+curve *rdp_with_stats(curve const *start, double epsilon,
+                      struct rdp_stats *stats);
+
+/**
+ * Runs rdp on _start_ and sets bit i % 64 of mask[i / 64] for every kept
+ * point i, clearing all other bits. _mask_ must have room for
+ * RDP_MASK_WORDS(start->length) words. Only the indices in _ws_ are used.
+ *
+ * returns: the number of kept points
+ */
+int rdp_mask(curve const *start, double epsilon, uint64_t *mask,
+             struct rdp_workspace *ws);
+
+#define RDP_MASK_WORDS(length) (((length) + 63) / 64)
+
+/**
+ * The points kept by rdp read through the curve they came from. Only the
+ * indices are stored, so _source_ must outlive the view and the view is only
+ * valid until the workspace that made it is used again or freed.
+ */
+struct curve_view {
+  curve const *source;
+  int const *indices;
+  int length;
+};
+
+/**
+ * Runs rdp on _start_ and returns a view of the kept points that refers to
+ * _start_ and ws->indices instead of copying any points.
+ */
+struct curve_view rdp_view(curve const *start, double epsilon,
+                           struct rdp_workspace *ws);
+
+/**
+ * returns: the _i_th kept point of _view_
+ */
+static inline point curve_view_at(struct curve_view const *view, int i) {
+  return view->source->points[view->indices[i]];
+}
+
 /**
  * Caller must free return value using curve_linear_free
  * Implementation note: delta is treated as a maximum.
  * points may be closer together than delta but will not
- * be further apart than delta
+ * be further apart than delta. The ith point is at start + i * delta and
+ * the last point is exactly (x2, y2).
+ * Returns NULL if delta is not positive or the line would need more than
+ * INT_MAX points.
  */
 curve *curve_from_line(double x1, double y1, double x2, double y2,
                        double delta);
@@ -34,7 +223,10 @@ curve *curve_from_line(double x1, double y1, double x2, double y2,
  * Caller must free return value using curve_quadratic_free
  * Implementation note: delta is treated as a maximum.
  * points may be closer together than delta but will not
- * be further apart than delta
+ * be further apart than delta. The ith x is xstart + i * delta and the
+ * last x is exactly xend.
+ * Returns NULL if delta is not positive or the curve would need more than
+ * INT_MAX points.
  */
 curve *curve_from_quadratic(double a, double b, double c, double xstart,
                             double xend, double delta);
@@ -43,11 +235,50 @@ curve *curve_from_quadratic(double a, double b, double c, double xstart,
  * Caller must free return value using curve_construct_free
  * Implementation note: delta is treated as a maximum.
  * points may be closer together than delta but will not
- * be further apart than delta
+ * be further apart than delta. The ith x is startX + i * delta and the
+ * last x is exactly endX. The points are allocated once and, see
+ * curve_set_parallel_construct, f may be called from several threads.
+ * Returns NULL if delta is not positive or the curve would need more than
+ * INT_MAX points.
  */
 curve *curve_construct(double startX, double endX, double delta,
                        double (*f)(double));
 
+/**
+ * Caller must free return value using rdp_result_free
+ * Creates a curve between startX and endX that follows f to within epsilon
+ * using only as many points as that needs. f is only evaluated where it
+ * bends: the samples curve_construct would take are split into _segments_
+ * runs and a run is only subdivided if the samples a quarter, half or three
+ * quarters of the way along it are epsilon / 2 or more from its chord. The
+ * result is then simplified with rdp at epsilon / 2, so its points are a
+ * subset of those of curve_construct(startX, endX, delta, f).
+ * Features narrower than the initial runs can be missed, so raise
+ * _segments_ for functions that oscillate quickly.
+ * Returns NULL if delta is not positive or the curve would need more than
+ * INT_MAX points.
+ */
+curve *curve_adaptive(double startX, double endX, double delta,
+                      double epsilon, double (*f)(double), int segments);
+
+/**
+ * Makes _out_ refer to the points of a mapped curve file without copying or
+ * parsing them. _out_ is valid until _map_ is closed and must not be
+ * freed.
+ *
+ * returns: false, leaving _out_ unchanged, if the file does not hold
+ * interleaved 2D double points or holds more than INT_MAX of them
+ */
+bool curve_from_file_map(struct curve_file_map const *map, curve *out);
+
+/**
+ * Saves the points of _c_ to _path_ as an interleaved 2D double curve file
+ * that curve_from_file_map can use directly.
+ *
+ * returns: false, with errno set, if the file could not be written
+ */
+bool curve_write_file(char const *path, curve const *c);
+
 void rdp_result_free(curve *c);
 void curve_construct_free(curve *c);
 void curve_quadratic_free(curve *c);
@@ -3,6 +3,19 @@
 
 #include "legacysupport.hpp"
 #include "point.hpp"
+#include "rdp_engine.hpp"
+#include "rdp_kernel.hpp"
+#include "rdp_parallel.hpp"
+#include "rdp_result.hpp"
+#include "rdp_stats.hpp"
+#include "simplifier.hpp"
+#include "thread_pool.hpp"
+#include "visvalingam.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <vector>
@@ -11,72 +24,260 @@ template <FLOATING_POINT_CONCEPT T = double> struct sortXs {
   bool operator()(auto a, auto b) { return a.x < b.x; }
 };
 
+/**
+ * The _i_th of _count_ samples from _start_ to _end_ at most _delta_ apart.
+ * Every sample is computed from _start_ rather than by adding _delta_ to the
+ * previous one, so no rounding error builds up along the curve, and the last
+ * sample is exactly _end_.
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] T sample_at(T start, T end, T delta, std::size_t count,
+                          std::size_t i) {
+  using W = std::common_type_t<T, double>;
+  if (i + 1 == count)
+    return end;
+  return static_cast<T>(W(start) + W(i) * W(delta));
+}
+
+/**
+ * The number of samples from _start_ to _end_ at most _delta_ apart: every
+ * start + i * delta that is below _end_, then _end_ itself. Throws
+ * std::invalid_argument if _delta_ is not positive and std::length_error if
+ * there would be too many samples to index.
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::size_t sample_count(T start, T end, T delta) {
+  using W = std::common_type_t<T, double>;
+  if (!(delta > 0))
+    throw std::invalid_argument("delta must be positive");
+  if (!(end > start))
+    return 1;
+
+  W estimate = std::ceil((W(end) - W(start)) / W(delta));
+  if (!(estimate < W(1ull << 62)))
+    throw std::length_error("too many samples between start and end");
+
+  // the estimate can be off by one either way after rounding, so it is
+  // settled with the same arithmetic sample_at uses
+  auto below = [&](std::size_t i) {
+    return static_cast<T>(W(start) + W(i) * W(delta)) < end;
+  };
+  auto k = static_cast<std::size_t>(estimate);
+  while (k > 0 && !below(k - 1))
+    k--;
+  while (below(k))
+    k++;
+  return k + 1;
+}
+
+/**
+ * The samples of construct(startX, endX, delta, f) needed to follow f to
+ * within _epsilon_, found by only subdividing where f bends. The samples
+ * are first split into _segments_ equal runs. A run is kept as a chord if
+ * the samples a quarter, half and three quarters of the way along it are
+ * closer than _epsilon_ to it, otherwise it is split at the furthest of
+ * them and both halves are checked the same way.
+ *
+ * Flat regions cost a few evaluations of f however many samples they span.
+ * Features narrower than the probes of the initial runs can be missed, so
+ * _segments_ should be raised for functions that oscillate quickly.
+ *
+ * returns: the first sample and the end of every kept chord in ascending x
+ */
+template <FLOATING_POINT_CONCEPT T, typename F>
+[[nodiscard]] std::vector<point<T>> adaptive_samples(T startX, T endX, T delta,
+                                                     double epsilon, F &&f,
+                                                     int segments = 16) {
+  struct pending {
+    std::size_t start, end;
+    point<T> s, e;
+  };
+
+  std::size_t count = sample_count(startX, endX, delta);
+  auto at = [&](std::size_t i) {
+    T x = sample_at(startX, endX, delta, count, i);
+    return point<T>{x, f(x)};
+  };
+
+  std::vector<point<T>> result;
+  result.push_back(at(0));
+  if (count == 1)
+    return result;
+
+  // the initial runs are pushed right to left so they are refined left to
+  // right and the output comes out in order
+  std::size_t last = count - 1;
+  std::size_t runs = std::clamp<std::size_t>(segments, 1, last);
+  std::vector<pending> stack;
+  std::size_t end = last;
+  point<T> e = at(end);
+  for (std::size_t k = runs - 1; k > 0; k--) {
+    std::size_t start = k * (last / runs) + std::min(k, last % runs);
+    point<T> s = at(start);
+    stack.push_back({start, end, s, e});
+    end = start;
+    e = s;
+  }
+  stack.push_back({0, end, result.front(), e});
+
+  while (!stack.empty()) {
+    auto p = stack.back();
+    stack.pop_back();
+
+    std::size_t span = p.end - p.start;
+    if (span >= 2) {
+      point<T> probes[3];
+      std::size_t indices[3];
+      int n = 0;
+      for (std::size_t q = 1; q <= 3; q++) {
+        std::size_t i = p.start + span * q / 4;
+        if (i > p.start && (n == 0 || i != indices[n - 1])) {
+          indices[n] = i;
+          probes[n++] = at(i);
+        }
+      }
+
+      rdp_metric_t<T> metric;
+      int j = argmax_metric(probes, 0, n, p.s, p.e, metric);
+      if (j != -1 && !(metric_distance(p.s, p.e, metric) < epsilon)) {
+        // the left half is pushed last so it is finished first
+        stack.push_back({indices[j], p.end, probes[j], p.e});
+        stack.push_back({p.start, indices[j], p.s, probes[j]});
+        continue;
+      }
+    }
+    result.push_back(p.e);
+  }
+  return result;
+}
+
 /**
  * Class representing a curve composed of discrete points
  * Curve can be simplified using the Ramer-Douglas-Peuker
- * algorithm.
+ * algorithm or the Visvalingam-Whyatt algorithm.
  *
  * Implementation note: delta is treated as a maximum.
  * points may be closer together than delta but will not
  * be further apart than delta
+ *
+ * Curves of points with _N_ coordinates, such as GPS tracks with altitude,
+ * are simplified in one pass over all coordinates. The constructors from
+ * functions, the sorting by x and the parallel rdp only exist for 2D curves.
  */
-template <FLOATING_POINT_CONCEPT T = double> struct curve {
+template <FLOATING_POINT_CONCEPT T = double, std::size_t N = 2> struct curve {
+
+  curve() = default;
+
+  /**
+   * Create a curve that takes ownership of _points_. The points should
+   * already be sorted by their x coordinate.
+   */
+  explicit curve(std::vector<point<T, N>> points) : points_(std::move(points)) {}
 
   /**
    * Create a curve between startX and endX with a delta
-   * of at most delta and using the function f to get y values
+   * of at most delta and using the function f to get y values.
+   * The points are counted up front and written into one allocation.
    */
-  static curve<T> construct(T startX, T endX, T delta, auto f) {
-    curve<T> result;
-    for (; startX < endX; startX += delta)
-      result.addPoint(startX, f(startX));
-    result.addPoint(endX, f(endX));
-    return result;
+  static curve<T> construct(T startX, T endX, T delta, auto f)
+    requires(N == 2)
+  {
+    std::size_t count = sample_count(startX, endX, delta);
+    std::vector<point<T>> points;
+    points.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+      T x = sample_at(startX, endX, delta, count, i);
+      points.emplace_back(x, f(x));
+    }
+    return curve<T>{std::move(points)};
+  }
+
+  /**
+   * Same as construct(T, T, T, auto) but when there are at least 2 * _chunk_
+   * points f is evaluated in chunks of _chunk_ points on _executor_, so it
+   * must be safe to call from several threads at once. The result is the
+   * same as the serial version.
+   */
+  static curve<T> construct(T startX, T endX, T delta, auto f,
+                            thread_pool &executor,
+                            std::size_t chunk = 1 << 16)
+    requires(N == 2)
+  {
+    std::size_t count = sample_count(startX, endX, delta);
+    chunk = std::max<std::size_t>(chunk, 1);
+    if (count < 2 * chunk || executor.size() < 2)
+      return construct(startX, endX, delta, f);
+
+    std::vector<point<T>> points(count);
+    {
+      task_group group(executor);
+      for (std::size_t first = 0; first < count; first += chunk) {
+        group.run([&, first] {
+          std::size_t last = std::min(first + chunk, count);
+          for (std::size_t i = first; i < last; i++) {
+            T x = sample_at(startX, endX, delta, count, i);
+            points[i] = point<T>{x, f(x)};
+          }
+        });
+      }
+      group.wait();
+    }
+    return curve<T>{std::move(points)};
+  }
+
+  /**
+   * Create a curve between startX and endX that follows f to within
+   * epsilon using only as many points as that needs. Instead of sampling
+   * every delta and simplifying afterwards, f is only evaluated where it
+   * bends, see adaptive_samples, and what that finds at epsilon / 2 is
+   * simplified at epsilon / 2. The points are a subset of
+   * construct(startX, endX, delta, f).
+   */
+  static curve<T> adaptive(T startX, T endX, T delta, double epsilon, auto f,
+                           int segments = 16)
+    requires(N == 2)
+  {
+    curve<T> sampled{
+        adaptive_samples(startX, endX, delta, epsilon / 2, f, segments)};
+    return sampled.rdp(epsilon / 2);
   }
 
   /**
    * Construct a quadratic curve between xstart and xend
    * The form is y=ax^2 + bx + c
    */
-  static curve<T> quadratic(T a, T b, T c, T xstart, T xend, T delta = 0.01) {
-    auto equation = [&](T x) { return a * std::pow(x, 2) + b * x + c; };
-    curve<T> result;
-    for (double x = xstart; x < xend; x += delta)
-      result.addPoint(x, equation(x));
-    result.addPoint(xend, f(xend));
-    return result;
+  static curve<T> quadratic(T a, T b, T c, T xstart, T xend, T delta = 0.01)
+    requires(N == 2)
+  {
+    return construct(xstart, xend, delta,
+                     [=](T x) { return a * (x * x) + b * x + c; });
   }
 
   /**
    * Construct a line between the two points (x1, y1) and (x2, y2) with
    * at most delta space between x-coordinates of the points
    */
-  static curve<T> line_between(T x1, T y1, T x2, T y2, T delta = 0.01) {
+  static curve<T> line_between(T x1, T y1, T x2, T y2, T delta = 0.01)
+    requires(N == 2)
+  {
     T slope = (y2 - y1) / (x2 - x1);
-    curve<T> result;
-    if (isinf(slope)) {
-      if (y2 < y1) {
-        for (T start = y1; start > y2; start -= delta) {
-          result.addPoint(point<T>{x1, start});
-        }
-      } else {
-        for (T start = y1; start < y2; start += delta) {
-          result.addPoint(point<T>{x1, start});
-        }
-      }
-      result.addPoint(point<T>{x2, y2});
-    } else {
-      auto equation = [&](T x) { return slope * x - slope * x1 + y1; };
-      for (T start = x1; start < x2; start += delta) {
-        T y = equation(start);
-        result.addPoint(point{start, y});
-      }
-      result.addPoint(x2, equation(x2));
-    }
-    return result;
+    if (!std::isinf(slope))
+      return construct(x1, x2, delta,
+                       [=](T x) { return slope * x - slope * x1 + y1; });
+
+    // vertical lines are sampled along y, walking down if y2 is below y1
+    T sign = y2 < y1 ? -1 : 1;
+    std::size_t count = sample_count(sign * y1, sign * y2, delta);
+    std::vector<point<T>> points;
+    points.reserve(count);
+    for (std::size_t i = 0; i + 1 < count; i++)
+      points.emplace_back(x1, sign * sample_at(sign * y1, sign * y2, delta,
+                                               count, i));
+    points.emplace_back(x2, y2);
+    return curve<T>{std::move(points)};
   }
 
-  [[nodiscard]] std::vector<point<T>> const &points() const noexcept {
+  [[nodiscard]] std::vector<point<T, N>> const &points() const noexcept {
     return points_;
   }
 
@@ -91,7 +292,7 @@ template <FLOATING_POINT_CONCEPT T = double> struct curve {
    * also be used to add all points quickly then sortPoints() can be
    * called to sort the existing points by x
    */
-  void addPoint(point<T> const &p) { points_.push_back(p); }
+  void addPoint(point<T, N> const &p) { points_.push_back(p); }
 
   /**
    * Add a point to the curve. Note that this method does no sorting
@@ -102,7 +303,11 @@ template <FLOATING_POINT_CONCEPT T = double> struct curve {
    * also be used to add all points quickly then sortPoints() can be
    * called to sort the existing points by x
    */
-  void addPoint(T x, T y) { points_.emplace_back(x, y); }
+  void addPoint(T x, T y)
+    requires(N == 2)
+  {
+    points_.emplace_back(x, y);
+  }
 
   /**
    * Add a point in the correct position.
@@ -111,7 +316,9 @@ template <FLOATING_POINT_CONCEPT T = double> struct curve {
    * This method uses a linear search to place the new point, and
    * requires the points to already be sorted.
    */
-  void addPointSorted(point<T> const &p) {
+  void addPointSorted(point<T> const &p)
+    requires(N == 2)
+  {
     for (auto it = points().begin(); it < points().end(); it++) {
       if (p.x > it->x) {
         points_.insert(it, p);
@@ -121,55 +328,245 @@ template <FLOATING_POINT_CONCEPT T = double> struct curve {
     points_.push_back(p);
   }
 
-  void sortPoints() {
+  void sortPoints()
+    requires(N == 2)
+  {
     std::sort(std::begin(points_), std::end(points_), sortXs{});
   }
 
+  /**
+   * Returns the index of the point between start and end that is furthest
+   * from the line through points()[start] and points()[end] along with that
+   * distance. The index is -1 if every point is on the line.
+   */
   [[nodiscard]] auto furthestPoint(int start, int end) const {
+    return furthest_point(points_.data(), start, end);
+  }
 
-    int furthestIndex = -1;
-    T recordDist = 0;
-
-    point<T> const &s = points_[start];
-    point<T> const &e = points_[end];
-    for (int i = start + 1; i < end; i++) {
-      T t = points_[i].p2ldist(s, e);
-      if (t > recordDist) {
-        furthestIndex = i;
-        recordDist = t;
-      }
-    }
-    return std::make_tuple(furthestIndex, recordDist);
+  /**
+   * Same as furthestPoint(int, int) but scans of at least _scanCutoff_ points
+   * are split into chunks that run in parallel on _executor_. The result is
+   * the same as the serial scan.
+   */
+  [[nodiscard]] auto
+  furthestPoint(int start, int end, thread_pool &executor,
+                int scanCutoff = rdp_default_scan_cutoff) const
+    requires(N == 2)
+  {
+    return furthest_point(points_.data(), start, end, executor, scanCutoff);
   }
 
+  /**
+   * Simplify the curve using the Ramer-Douglas-Peuker algorithm. Points that
+   * are less than epsilon from the line between the kept points around them
+   * are removed.
+   */
   curve rdp(double epsilon) const {
-    curve result;
+    rdp_workspace<T, N> ws;
+    rdp_simplify(points_.data(), static_cast<int>(length()), epsilon, ws);
+    return curve{ws.take_points()};
+  }
 
-    result.addPoint(points_.front());
-    rdp_support(epsilon, 0, length() - 1, result);
-    result.addPoint(points_.back());
+  /**
+   * Same as rdp(double) but fills in _stats_ with what the simplification
+   * did and, if _trace_ is not null, records trace events for its phases
+   * and large scans. rdp(double) itself is not instrumented at all.
+   */
+  curve rdp(double epsilon, rdp_stats &stats,
+            rdp_trace *trace = nullptr) const {
+    rdp_workspace<T, N> ws;
+    rdp_stats_collector collector(stats, trace);
+    rdp_simplify(points_.data(), static_cast<int>(length()), epsilon, ws,
+                 collector);
+    return curve{ws.take_points()};
+  }
 
-    return result;
+  /**
+   * Same as rdp(double) but uses the buffers in _ws_ and returns a reference
+   * to the kept points stored there. Reusing one workspace for repeated
+   * calls avoids allocating once it is large enough.
+   */
+  std::vector<point<T, N>> const &rdp(double epsilon,
+                                      rdp_workspace<T, N> &ws) const {
+    rdp_simplify(points_.data(), static_cast<int>(length()), epsilon, ws);
+    return ws.points();
   }
 
-private:
-  std::vector<point<T>> points_;
+  /**
+   * Same as rdp(double) but runs the independent halves of large splits as
+   * tasks on _executor_. Ranges shorter than _cutoff_ points are simplified
+   * inline and scans of at least _scanCutoff_ points are split across the
+   * threads. The result is the same as rdp(double) for any number of threads.
+   */
+  curve rdp(double epsilon, thread_pool &executor,
+            int cutoff = rdp_default_task_cutoff,
+            int scanCutoff = rdp_default_scan_cutoff) const
+    requires(N == 2)
+  {
+    rdp_workspace<T> ws;
+    rdp_simplify(points_.data(), static_cast<int>(length()), epsilon, executor,
+                 ws, cutoff, scanCutoff);
+    return curve{ws.take_points()};
+  }
 
-  void rdp_support(double epsilon, int sidx, int eidx, curve &result) const {
+  /**
+   * Simplify the curve to exactly _count_ points, or every point that is
+   * not on a line through its neighbours if there are fewer, by always
+   * splitting the segment with the largest deviation next.
+   *
+   * returns: the simplified curve and the epsilon that was reached, which is
+   * the largest distance of a dropped point from the result
+   */
+  [[nodiscard]] std::tuple<curve, double> rdp_to_count(int count) const {
+    std::vector<int> kept;
+    point<T, N> const *points = points_.data();
+    double epsilon = rdp_refine_by(
+        static_cast<int>(length()) - 1, count,
+        [points](int s, int e) { return furthest_point(points, s, e); }, kept);
 
-    if (sidx >= eidx)
-      return;
+    std::vector<point<T, N>> result;
+    result.reserve(kept.size());
+    for (int i : kept)
+      result.push_back(points_[i]);
+    return std::make_tuple(curve{std::move(result)}, epsilon);
+  }
 
-    auto [furthestIdx, d] = furthestPoint(sidx, eidx);
-    if (furthestIdx != -1) {
-      if (d < epsilon) {
-        return;
-      } else {
-        rdp_support(epsilon, sidx, furthestIdx, result);
-        result.points_.push_back(points_[furthestIdx]);
-        rdp_support(epsilon, furthestIdx, eidx, result);
-      }
-    }
+  /**
+   * Same as rdp(double) but only returns the indices of the kept points in
+   * ascending order. No points are copied.
+   */
+  [[nodiscard]] std::vector<int> rdp_indices(double epsilon) const {
+    rdp_workspace<T, N> ws;
+    rdp_simplify_indices(points_.data(), static_cast<int>(length()), epsilon,
+                         ws);
+    return ws.take_indices();
+  }
+
+  /**
+   * Same as rdp_indices(double) but uses the buffers in _ws_ and returns a
+   * reference to ws.indices(), which is valid until _ws_ is used again
+   */
+  std::vector<int> const &rdp_indices(double epsilon,
+                                      rdp_workspace<T, N> &ws) const {
+    rdp_simplify_indices(points_.data(), static_cast<int>(length()), epsilon,
+                         ws);
+    return ws.indices();
+  }
+
+  /**
+   * Same as rdp(double) but returns one bit per point of this curve that is
+   * set if the point was kept
+   */
+  [[nodiscard]] rdp_mask rdp_bitmask(double epsilon) const {
+    rdp_workspace<T, N> ws;
+    rdp_simplify_indices(points_.data(), static_cast<int>(length()), epsilon,
+                         ws);
+    rdp_mask mask(length());
+    for (int i : ws.indices())
+      mask.set(static_cast<std::size_t>(i));
+    return mask;
+  }
+
+  /**
+   * Same as rdp(double) but returns a view of the kept points that reads
+   * them from this curve. This curve must outlive the view and must not
+   * have points added while it is in use.
+   */
+  [[nodiscard]] curve_view<T, N> rdp_view(double epsilon) const {
+    return curve_view<T, N>{std::span<point<T, N> const>{points_},
+                         rdp_indices(epsilon)};
+  }
+
+  /**
+   * Simplify the curve using the Visvalingam-Whyatt algorithm. The point
+   * making the smallest triangle with its neighbours is removed until every
+   * remaining triangle has at least _area_.
+   */
+  curve visvalingam(double area) const {
+    simplify_buffers ws;
+    visvalingam_simplify(points_.data(), static_cast<int>(length()), area,
+                         static_cast<int>(length()), ws);
+    return gather(ws.indices());
+  }
+
+  /**
+   * Simplify the curve to _count_ points, or to its two endpoints if
+   * _count_ is smaller, using the Visvalingam-Whyatt algorithm
+   *
+   * returns: the simplified curve and the largest triangle area that was
+   * removed
+   */
+  [[nodiscard]] std::tuple<curve, double>
+  visvalingam_to_count(int count) const {
+    simplify_buffers ws;
+    double area = visvalingam_simplify(
+        points_.data(), static_cast<int>(length()), 0, count, ws);
+    return std::make_tuple(gather(ws.indices()), area);
+  }
+
+  /**
+   * Drop every point closer than _tolerance_ to the last point kept, in one
+   * pass. See prefilter.hpp.
+   */
+  curve radial_distance(double tolerance) const {
+    return simplify(radial_distance_simplifier{tolerance});
+  }
+
+  /**
+   * Drop the points that stay in a strip _tolerance_ wide around the line
+   * from the last point kept, in one pass. See prefilter.hpp.
+   */
+  curve reumann_witkam(double tolerance) const {
+    return simplify(reumann_witkam_simplifier{tolerance});
+  }
+
+  /**
+   * Simplify the curve with rdp after dropping most of the points of an
+   * oversampled curve with reumann_witkam at _tolerance_, which must be
+   * smaller than _epsilon_. rdp is run at epsilon - tolerance so every
+   * dropped point is within _epsilon_ of the result, as with rdp(epsilon),
+   * but rdp only has to scan what the filter keeps.
+   */
+  curve rdp_prefiltered(double epsilon, double tolerance) const {
+    if (!(tolerance >= 0 && tolerance < epsilon))
+      throw std::invalid_argument(
+          "prefilter tolerance must be between 0 and epsilon");
+    return simplify(prefiltered_simplifier<reumann_witkam_simplifier,
+                                           rdp_simplifier>{
+        {tolerance}, {epsilon - tolerance}});
+  }
+
+  /**
+   * Simplify the curve with any algorithm from simplifier.hpp, for example
+   * simplify(rdp_simplifier{0.1}) or simplify(visvalingam_simplifier{0.5})
+   */
+  template <typename S>
+    requires curve_simplifier<S, T, N>
+  [[nodiscard]] curve simplify(S const &s) const {
+    return gather(simplify_indices(s));
+  }
+
+  /**
+   * Same as simplify but only returns the indices of the kept points in
+   * ascending order
+   */
+  template <typename S>
+    requires curve_simplifier<S, T, N>
+  [[nodiscard]] std::vector<int> simplify_indices(S const &s) const {
+    std::vector<int> kept;
+    s.simplify(points_.data(), static_cast<int>(length()), kept);
+    return kept;
+  }
+
+private:
+  std::vector<point<T, N>> points_;
+
+  [[nodiscard]] curve gather(std::span<int const> indices) const {
+    std::vector<point<T, N>> result;
+    result.reserve(indices.size());
+    for (int i : indices)
+      result.push_back(points_[i]);
+    return curve{std::move(result)};
   }
 };
 
@@ -0,0 +1,490 @@
+#ifndef CURVE_CODEC_HPP
+#define CURVE_CODEC_HPP
+
+#include "curve.hpp"
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_result.hpp"
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Compressed curves are a 32 byte header followed by blocks of up to 64
+ * points. Coordinates are rounded to a fixed grid, so each one becomes an
+ * integer count of grid steps. Each point is then predicted from the points
+ * before it, and only the difference from the prediction is kept, zigzag
+ * encoded so that small negative numbers stay small.
+ *
+ * A block starts with two bytes giving the bit width of its largest x and y
+ * difference. Then come the x differences packed at that width, and then
+ * the y differences, each padded to a whole byte. Unpacking a block takes
+ * the same steps for every value, with no branch per value, which is what
+ * makes decoding fast. 16 zero bytes follow the last block so the decoder
+ * can always load whole words.
+ *
+ * Every number in the format has a fixed byte order, so a compressed curve
+ * can be read back on any machine. The header is:
+ *
+ *   magic "RDPZ", version u8, order u8, 2 reserved bytes,
+ *   count u64, x resolution f64, y resolution f64
+ */
+#define CURVE_CODEC_MAGIC "RDPZ"
+#define CURVE_CODEC_VERSION 1
+#define CURVE_CODEC_HEADER_SIZE 32
+#define CURVE_CODEC_BLOCK 64
+#define CURVE_CODEC_PADDING 16
+
+/**
+ * How curve_encoder rounds and predicts points
+ */
+struct curve_codec_options {
+  // coordinates are rounded to the nearest multiple of these, so a decoded
+  // coordinate is within half of its resolution of the original
+  double xResolution = 1e-6;
+  double yResolution = 1e-6;
+  // 1 predicts that a point is where the previous one was, 2 that it
+  // continues the line through the previous two. Evenly spaced x values
+  // then take no bits at all.
+  int order = 2;
+};
+
+namespace curve_codec_detail {
+
+inline void put_u64(std::uint8_t *out, std::uint64_t v) {
+  for (int i = 0; i < 8; i++)
+    out[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+inline std::uint64_t get_u64(std::uint8_t const *in) {
+  std::uint64_t v = 0;
+  for (int i = 0; i < 8; i++)
+    v |= static_cast<std::uint64_t>(in[i]) << (8 * i);
+  return v;
+}
+
+/**
+ * The residual of _value_ from _prediction_. Grid counts are handled as
+ * unsigned so that differences wrap instead of overflowing.
+ */
+inline std::uint64_t zigzag(std::uint64_t value, std::uint64_t prediction) {
+  auto r = static_cast<std::int64_t>(value - prediction);
+  return (static_cast<std::uint64_t>(r) << 1) ^
+         static_cast<std::uint64_t>(r >> 63);
+}
+
+inline std::uint64_t unzigzag(std::uint64_t z) {
+  return (z >> 1) ^ (0 - (z & 1));
+}
+
+inline std::uint64_t predict(int order, std::uint64_t previous,
+                             std::uint64_t beforePrevious) {
+  return order == 2 ? 2 * previous - beforePrevious : previous;
+}
+
+inline std::size_t packed_bytes(int count, int width) {
+  return (static_cast<std::size_t>(count) * width + 7) / 8;
+}
+
+/**
+ * Appends _count_ values of _width_ bits each, lowest bits first
+ */
+inline void pack(std::vector<std::uint8_t> &out, std::uint64_t const *values,
+                 int count, int width) {
+  std::size_t at = out.size();
+  out.resize(at + packed_bytes(count, width));
+  std::uint8_t *dst = out.data() + at;
+
+  unsigned __int128 acc = 0;
+  int bits = 0;
+  for (int i = 0; i < count; i++) {
+    acc |= static_cast<unsigned __int128>(values[i]) << bits;
+    bits += width;
+    while (bits >= 8) {
+      *dst++ = static_cast<std::uint8_t>(acc);
+      acc >>= 8;
+      bits -= 8;
+    }
+  }
+  if (bits > 0)
+    *dst = static_cast<std::uint8_t>(acc);
+}
+
+inline std::uint64_t load_u64(std::uint8_t const *in) {
+  if constexpr (std::endian::native == std::endian::little) {
+    std::uint64_t v;
+    std::memcpy(&v, in, sizeof(v));
+    return v;
+  } else {
+    return get_u64(in);
+  }
+}
+
+/**
+ * Reads _count_ values of _width_ bits each. At least 16 bytes past the
+ * packed values must be readable.
+ */
+inline void unpack(std::uint8_t const *in, std::uint64_t *values, int count,
+                   int width) {
+  if (width == 0) {
+    std::fill(values, values + count, 0);
+  } else if (width <= 57) {
+    // a value this narrow always fits in the word loaded at its first byte
+    std::uint64_t mask = (std::uint64_t{1} << width) - 1;
+    for (int i = 0; i < count; i++) {
+      std::size_t bit = static_cast<std::size_t>(i) * width;
+      values[i] = (load_u64(in + bit / 8) >> (bit % 8)) & mask;
+    }
+  } else {
+    std::uint64_t mask =
+        width == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1;
+    for (int i = 0; i < count; i++) {
+      std::size_t bit = static_cast<std::size_t>(i) * width;
+      unsigned shift = bit % 8;
+      std::uint64_t v = load_u64(in + bit / 8) >> shift;
+      if (shift != 0)
+        v |= load_u64(in + bit / 8 + 8) << (64 - shift);
+      values[i] = v & mask;
+    }
+  }
+}
+
+} // namespace curve_codec_detail
+
+/**
+ * Compresses points one at a time into the format described above. Points
+ * can come from anywhere, for example the emit callback of a
+ * streaming_simplifier, so a simplified stream can be compressed without
+ * ever being held in memory.
+ */
+template <FLOATING_POINT_CONCEPT T = double> class curve_encoder {
+public:
+  /**
+   * Throws std::invalid_argument if a resolution is not positive and finite
+   * or _order_ is not 1 or 2
+   */
+  explicit curve_encoder(curve_codec_options options = {})
+      : options_(options) {
+    if (!(options.xResolution > 0) || !std::isfinite(options.xResolution) ||
+        !(options.yResolution > 0) || !std::isfinite(options.yResolution))
+      throw std::invalid_argument("curve codec resolutions must be positive");
+    if (options.order != 1 && options.order != 2)
+      throw std::invalid_argument("curve codec order must be 1 or 2");
+
+    bytes_.resize(CURVE_CODEC_HEADER_SIZE);
+    std::memcpy(bytes_.data(), CURVE_CODEC_MAGIC, 4);
+    bytes_[4] = CURVE_CODEC_VERSION;
+    bytes_[5] = static_cast<std::uint8_t>(options.order);
+    curve_codec_detail::put_u64(
+        bytes_.data() + 16, std::bit_cast<std::uint64_t>(options.xResolution));
+    curve_codec_detail::put_u64(
+        bytes_.data() + 24, std::bit_cast<std::uint64_t>(options.yResolution));
+  }
+
+  /**
+   * Reserves room for about _points_ more points, assuming they compress to
+   * a few bytes each
+   */
+  void reserve(std::size_t points) {
+    bytes_.reserve(bytes_.size() + 4 * points);
+  }
+
+  /**
+   * Add the next point. Throws std::out_of_range if a coordinate is not
+   * finite or is too far from 0 to count in grid steps.
+   */
+  void addPoint(point<T> const &p) {
+    std::uint64_t qx = quantize(p.x, options_.xResolution);
+    std::uint64_t qy = quantize(p.y, options_.yResolution);
+
+    // the first point is predicted from the origin and the second from the
+    // first, since there is no line to continue yet
+    int order = count_ < 2 ? 1 : options_.order;
+    xs_[pending_] =
+        curve_codec_detail::zigzag(qx, curve_codec_detail::predict(order, x1_, x0_));
+    ys_[pending_] =
+        curve_codec_detail::zigzag(qy, curve_codec_detail::predict(order, y1_, y0_));
+    x0_ = x1_;
+    y0_ = y1_;
+    x1_ = qx;
+    y1_ = qy;
+    count_++;
+
+    if (++pending_ == CURVE_CODEC_BLOCK)
+      flush_block();
+  }
+
+  void addPoint(T x, T y) { addPoint(point<T>{x, y}); }
+
+  template <typename It> void addPoints(It first, It last) {
+    for (; first != last; ++first)
+      addPoint(*first);
+  }
+
+  [[nodiscard]] std::size_t length() const noexcept { return count_; }
+
+  /**
+   * Writes the last block, completes the header and hands over the
+   * compressed bytes. The encoder is empty afterwards and must not be used
+   * again.
+   */
+  [[nodiscard]] std::vector<std::uint8_t> finish() {
+    flush_block();
+    bytes_.resize(bytes_.size() + CURVE_CODEC_PADDING);
+    curve_codec_detail::put_u64(bytes_.data() + 8, count_);
+    return std::move(bytes_);
+  }
+
+private:
+  static std::uint64_t quantize(T value, double resolution) {
+    // 2^62 steps leaves room for the prediction of order 2 to not overflow
+    double steps = std::nearbyint(static_cast<double>(value) / resolution);
+    if (!(std::fabs(steps) < 0x1p62))
+      throw std::out_of_range("coordinate cannot be encoded at the curve "
+                              "codec resolution");
+    return static_cast<std::uint64_t>(static_cast<std::int64_t>(steps));
+  }
+
+  static int width(std::uint64_t const *values, int count) {
+    std::uint64_t all = 0;
+    for (int i = 0; i < count; i++)
+      all |= values[i];
+    return std::bit_width(all);
+  }
+
+  void flush_block() {
+    if (pending_ == 0)
+      return;
+    int wx = width(xs_, pending_);
+    int wy = width(ys_, pending_);
+    bytes_.push_back(static_cast<std::uint8_t>(wx));
+    bytes_.push_back(static_cast<std::uint8_t>(wy));
+    curve_codec_detail::pack(bytes_, xs_, pending_, wx);
+    curve_codec_detail::pack(bytes_, ys_, pending_, wy);
+    pending_ = 0;
+  }
+
+  curve_codec_options options_;
+  std::vector<std::uint8_t> bytes_;
+  std::uint64_t count_ = 0;
+  // the grid counts of the previous point and the one before it
+  std::uint64_t x0_ = 0, y0_ = 0, x1_ = 0, y1_ = 0;
+  // the zigzag encoded differences of the block being filled
+  std::uint64_t xs_[CURVE_CODEC_BLOCK];
+  std::uint64_t ys_[CURVE_CODEC_BLOCK];
+  int pending_ = 0;
+};
+
+/**
+ * Compresses the points of _c_
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::vector<std::uint8_t>
+encode_curve(curve<T> const &c, curve_codec_options options = {}) {
+  curve_encoder<T> encoder(options);
+  encoder.reserve(c.length());
+  encoder.addPoints(c.points().begin(), c.points().end());
+  return encoder.finish();
+}
+
+/**
+ * Compresses the points of a simplification without copying them out first
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::vector<std::uint8_t>
+encode_curve(curve_view<T> const &view, curve_codec_options options = {}) {
+  curve_encoder<T> encoder(options);
+  encoder.reserve(view.size());
+  encoder.addPoints(view.begin(), view.end());
+  return encoder.finish();
+}
+
+/**
+ * Decompresses curves made by curve_encoder. The compressed bytes are read
+ * where they lie, so they can be a memory mapped file, and points come out
+ * in chunks through read(consume) like curve_reader, so they can be fed to a
+ * streaming_simplifier without decompressing the whole curve first.
+ */
+template <FLOATING_POINT_CONCEPT T = double> class curve_decoder {
+public:
+  /**
+   * Decodes _bytes_, which must outlive the decoder. Throws
+   * std::invalid_argument if they do not start with a valid header.
+   */
+  explicit curve_decoder(std::span<std::uint8_t const> bytes) : bytes_(bytes) {
+    if (bytes.size() < CURVE_CODEC_HEADER_SIZE + CURVE_CODEC_PADDING ||
+        std::memcmp(bytes.data(), CURVE_CODEC_MAGIC, 4) != 0 ||
+        bytes[4] != CURVE_CODEC_VERSION || (bytes[5] != 1 && bytes[5] != 2))
+      throw std::invalid_argument("not a compressed curve");
+
+    order_ = bytes[5];
+    count_ = curve_codec_detail::get_u64(bytes.data() + 8);
+    xResolution_ =
+        std::bit_cast<double>(curve_codec_detail::get_u64(bytes.data() + 16));
+    yResolution_ =
+        std::bit_cast<double>(curve_codec_detail::get_u64(bytes.data() + 24));
+    // every block takes at least its two width bytes
+    std::uint64_t blocks = (count_ + CURVE_CODEC_BLOCK - 1) / CURVE_CODEC_BLOCK;
+    if (blocks > (bytes.size() - CURVE_CODEC_HEADER_SIZE -
+                  CURVE_CODEC_PADDING) / 2)
+      throw std::invalid_argument("compressed curve is truncated");
+  }
+
+  /**
+   * The number of points in the curve
+   */
+  [[nodiscard]] std::size_t length() const noexcept {
+    return static_cast<std::size_t>(count_);
+  }
+
+  /**
+   * Decodes every remaining point and calls
+   * consume(std::span<point<T> const>) with up to _chunk_ points at a time,
+   * in order. Throws std::invalid_argument if the data is truncated or
+   * corrupt.
+   *
+   * returns: the number of points decoded
+   */
+  template <typename Consume>
+  std::size_t read(Consume &&consume, std::size_t chunk = 4096) {
+    std::vector<point<T>> points(std::max<std::size_t>(chunk, 1));
+    std::size_t total = 0;
+    while (remaining() > 0) {
+      std::size_t n = decode(points.data(), points.size());
+      consume(std::span<point<T> const>{points.data(), n});
+      total += n;
+    }
+    return total;
+  }
+
+  /**
+   * Decodes every remaining point into a curve
+   */
+  [[nodiscard]] curve<T> read_curve() {
+    std::vector<point<T>> points(remaining());
+    decode(points.data(), points.size());
+    return curve<T>{std::move(points)};
+  }
+
+private:
+  /**
+   * The number of points not handed out yet
+   */
+  [[nodiscard]] std::size_t remaining() const noexcept {
+    return static_cast<std::size_t>(count_ - decoded_) +
+           static_cast<std::size_t>(blockLength_ - blockAt_);
+  }
+
+  /**
+   * Decodes up to _max_ points into _out_, unpacking whole blocks straight
+   * into it and going through block_ only for a block that does not fit.
+   * returns: the number decoded
+   */
+  std::size_t decode(point<T> *out, std::size_t max) {
+    std::size_t n = 0;
+    while (n < max) {
+      if (blockAt_ < blockLength_) {
+        std::size_t take = std::min<std::size_t>(max - n, blockLength_ - blockAt_);
+        std::copy(block_ + blockAt_, block_ + blockAt_ + take, out + n);
+        blockAt_ += static_cast<int>(take);
+        n += take;
+        continue;
+      }
+      if (decoded_ == count_)
+        break;
+
+      int count = static_cast<int>(
+          std::min<std::uint64_t>(CURVE_CODEC_BLOCK, count_ - decoded_));
+      if (max - n >= static_cast<std::size_t>(count)) {
+        decode_block(out + n, count);
+        n += count;
+      } else {
+        decode_block(block_, count);
+        blockAt_ = 0;
+        blockLength_ = count;
+      }
+      decoded_ += count;
+    }
+    return n;
+  }
+
+  void decode_block(point<T> *out, int count) {
+    std::uint8_t const *in = bytes_.data() + offset_;
+    std::size_t available = bytes_.size() - offset_ - CURVE_CODEC_PADDING;
+    if (available < 2)
+      throw std::invalid_argument("compressed curve is truncated");
+    int wx = in[0];
+    int wy = in[1];
+    if (wx > 64 || wy > 64)
+      throw std::invalid_argument("compressed curve is corrupt");
+    std::size_t bx = curve_codec_detail::packed_bytes(count, wx);
+    std::size_t by = curve_codec_detail::packed_bytes(count, wy);
+    if (available - 2 < bx + by)
+      throw std::invalid_argument("compressed curve is truncated");
+
+    std::uint64_t xs[CURVE_CODEC_BLOCK], ys[CURVE_CODEC_BLOCK];
+    curve_codec_detail::unpack(in + 2, xs, count, wx);
+    curve_codec_detail::unpack(in + 2 + bx, ys, count, wy);
+    offset_ += 2 + bx + by;
+
+    // the state is kept in locals since stores to _out_ could otherwise
+    // alias the members and force them to be reloaded for every point
+    std::uint64_t x0 = x0_, y0 = y0_, x1 = x1_, y1 = y1_;
+    double xResolution = xResolution_, yResolution = yResolution_;
+    auto step = [&](int i, int order) {
+      std::uint64_t qx = curve_codec_detail::predict(order, x1, x0) +
+                         curve_codec_detail::unzigzag(xs[i]);
+      std::uint64_t qy = curve_codec_detail::predict(order, y1, y0) +
+                         curve_codec_detail::unzigzag(ys[i]);
+      x0 = x1;
+      y0 = y1;
+      x1 = qx;
+      y1 = qy;
+      out[i] = point<T>{
+          static_cast<T>(static_cast<std::int64_t>(qx) * xResolution),
+          static_cast<T>(static_cast<std::int64_t>(qy) * yResolution)};
+    };
+
+    int i = 0;
+    // the first two points of the curve have no line to continue
+    for (; i < count && decoded_ + i < 2; i++)
+      step(i, 1);
+    if (order_ == 2) {
+      for (; i < count; i++)
+        step(i, 2);
+    } else {
+      for (; i < count; i++)
+        step(i, 1);
+    }
+    x0_ = x0;
+    y0_ = y0;
+    x1_ = x1;
+    y1_ = y1;
+  }
+
+  std::span<std::uint8_t const> bytes_;
+  int order_;
+  std::uint64_t count_;
+  double xResolution_, yResolution_;
+  std::size_t offset_ = CURVE_CODEC_HEADER_SIZE;
+  std::uint64_t decoded_ = 0;
+  std::uint64_t x0_ = 0, y0_ = 0, x1_ = 0, y1_ = 0;
+  // a block that did not fit in the caller's buffer, handed out from blockAt_
+  point<T> block_[CURVE_CODEC_BLOCK];
+  int blockAt_ = 0, blockLength_ = 0;
+};
+
+/**
+ * Decompresses a whole curve made by curve_encoder
+ */
+template <FLOATING_POINT_CONCEPT T = double>
+[[nodiscard]] curve<T> decode_curve(std::span<std::uint8_t const> bytes) {
+  return curve_decoder<T>(bytes).read_curve();
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef CURVE_FILE_H
+#define CURVE_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Binary curve files are a fixed 64 byte header followed directly by the raw
+ * coordinates in the byte order of the machine that wrote them. Because the
+ * header size is a multiple of the vector width and mappings start on a page
+ * boundary, a mapped file can be handed to the simplification kernels as is.
+ *
+ * With CURVE_FILE_INTERLEAVED the coordinates of each point are stored next
+ * to each other, which is the layout of the C point and C++ point<T> arrays.
+ * With CURVE_FILE_SEPARATE all first coordinates come first, then all second
+ * coordinates and so on, which is the layout of curve_soa.
+ */
+#define CURVE_FILE_MAGIC "RDPC"
+#define CURVE_FILE_VERSION 1
+#define CURVE_FILE_BYTE_ORDER 0x01020304u
+
+enum curve_file_type { CURVE_FILE_FLOAT32 = 1, CURVE_FILE_FLOAT64 = 2 };
+
+enum curve_file_layout { CURVE_FILE_INTERLEAVED = 0, CURVE_FILE_SEPARATE = 1 };
+
+struct curve_file_header {
+  char magic[4];
+  uint16_t version;
+  /* offset of the coordinates from the start of the file, a multiple of the
+   * coordinate size so they can be read in place */
+  uint16_t header_size;
+  /* CURVE_FILE_BYTE_ORDER as written by the machine that made the file */
+  uint32_t byte_order;
+  uint8_t type;
+  uint8_t dimension;
+  uint8_t layout;
+  uint8_t reserved0;
+  uint64_t count;
+  uint8_t reserved[40];
+};
+
+/**
+ * A curve file mapped into memory with curve_file_open. _data_ points at the
+ * first coordinate. The mapping is private, so writing through _data_ never
+ * changes the file.
+ */
+struct curve_file_map {
+  void *base;
+  size_t size;
+  struct curve_file_header const *header;
+  void *data;
+};
+
+/**
+ * returns: the size in bytes of one coordinate of _type_, or 0 if _type_ is
+ * not a valid curve_file_type
+ */
+size_t curve_file_type_size(enum curve_file_type type);
+
+/**
+ * Writes _count_ points of _dimension_ coordinates each to _path_,
+ * replacing the file if it exists. For CURVE_FILE_INTERLEAVED coords[0]
+ * points at all of the coordinates. For CURVE_FILE_SEPARATE coords[d] points
+ * at the _count_ values of coordinate d.
+ *
+ * returns: false, with errno set, if the file could not be written
+ */
+bool curve_file_write(char const *path, enum curve_file_type type,
+                      int dimension, enum curve_file_layout layout,
+                      uint64_t count, void const *const *coords);
+
+/**
+ * Maps the curve file at _path_ into memory. Nothing is read or copied up
+ * front; pages are loaded as the coordinates are first touched.
+ *
+ * returns: false, with errno set, if the file cannot be opened or mapped or
+ * if its header is invalid, in which case errno is EINVAL. _map_ is only
+ * filled in when true is returned and must then be released with
+ * curve_file_close.
+ * Warning: _map_ cannot be NULL
+ */
+bool curve_file_open(char const *path, struct curve_file_map *map);
+
+void curve_file_close(struct curve_file_map *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
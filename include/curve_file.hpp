@@ -0,0 +1,171 @@
+#ifndef CURVE_FILE_HPP
+#define CURVE_FILE_HPP
+
+#include "curve.hpp"
+#include "curve_file.h"
+#include "curve_soa.hpp"
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * The curve_file_type that stores coordinates of type _T_
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] constexpr curve_file_type curve_file_type_of() {
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double>,
+                "curve files only store float and double coordinates");
+  return std::is_same_v<T, float> ? CURVE_FILE_FLOAT32 : CURVE_FILE_FLOAT64;
+}
+
+/**
+ * A curve file mapped into memory. The coordinates are used where they lie
+ * in the mapping, so opening a file of any size costs the same and pages are
+ * only read from disk once the simplification touches them.
+ *
+ * points() can be passed straight to rdp_simplify and the other functions of
+ * the engine. The mapping is private, so nothing done to it reaches the file.
+ */
+template <FLOATING_POINT_CONCEPT T = double, std::size_t N = 2>
+class mapped_curve {
+public:
+  /**
+   * Maps the curve file at _path_. Throws std::system_error if the file
+   * cannot be mapped and std::invalid_argument if it does not hold points
+   * of _N_ coordinates of type _T_.
+   */
+  explicit mapped_curve(std::string const &path) {
+    static_assert(sizeof(point<T, N>) == N * sizeof(T),
+                  "points are mapped as interleaved coordinates");
+
+    if (!curve_file_open(path.c_str(), &map_))
+      throw std::system_error(errno, std::generic_category(), path);
+
+    auto const *header = map_.header;
+    if (header->type != curve_file_type_of<T>() || header->dimension != N) {
+      curve_file_close(&map_);
+      throw std::invalid_argument(path + " does not hold points of the "
+                                         "requested type and dimension");
+    }
+  }
+
+  mapped_curve(mapped_curve &&other) noexcept
+      : map_(std::exchange(other.map_, curve_file_map{})) {}
+
+  mapped_curve &operator=(mapped_curve &&other) noexcept {
+    if (this != &other) {
+      curve_file_close(&map_);
+      map_ = std::exchange(other.map_, curve_file_map{});
+    }
+    return *this;
+  }
+
+  mapped_curve(mapped_curve const &) = delete;
+  mapped_curve &operator=(mapped_curve const &) = delete;
+
+  ~mapped_curve() { curve_file_close(&map_); }
+
+  [[nodiscard]] std::size_t length() const noexcept {
+    return static_cast<std::size_t>(map_.header->count);
+  }
+
+  [[nodiscard]] curve_file_layout layout() const noexcept {
+    return static_cast<curve_file_layout>(map_.header->layout);
+  }
+
+  /**
+   * The mapped points. Only valid for files with the interleaved layout.
+   */
+  [[nodiscard]] std::span<point<T, N> const> points() const {
+    if (layout() != CURVE_FILE_INTERLEAVED)
+      throw std::logic_error("curve file does not store interleaved points");
+    return {static_cast<point<T, N> const *>(map_.data), length()};
+  }
+
+  /**
+   * The mapped values of coordinate _d_. Only valid for files with the
+   * separate layout.
+   */
+  [[nodiscard]] std::span<T const> coordinate(std::size_t d) const {
+    if (layout() != CURVE_FILE_SEPARATE)
+      throw std::logic_error("curve file does not store separate coordinates");
+    return {static_cast<T const *>(map_.data) + d * length(), length()};
+  }
+
+  /**
+   * The mapped x coordinates. Only valid for files with the separate layout.
+   */
+  [[nodiscard]] std::span<T const> xs() const { return coordinate(0); }
+
+  /**
+   * The mapped y coordinates. Only valid for files with the separate layout.
+   */
+  [[nodiscard]] std::span<T const> ys() const { return coordinate(1); }
+
+  /**
+   * Copies the points into a curve regardless of the layout
+   */
+  [[nodiscard]] curve<T, N> to_curve() const {
+    std::vector<point<T, N>> points;
+    if (layout() == CURVE_FILE_INTERLEAVED) {
+      auto mapped = this->points();
+      points.assign(mapped.begin(), mapped.end());
+    } else {
+      points.resize(length());
+      for (std::size_t d = 0; d < N; d++) {
+        auto values = coordinate(d);
+        for (std::size_t i = 0; i < length(); i++)
+          points[i][d] = values[i];
+      }
+    }
+    return curve<T, N>{std::move(points)};
+  }
+
+private:
+  curve_file_map map_{};
+};
+
+/**
+ * Saves the _length_ points starting at _points_ to _path_ with the
+ * interleaved layout. Throws std::system_error if the file cannot be written.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void write_curve_file(std::string const &path, point<T, N> const *points,
+                      std::size_t length) {
+  static_assert(sizeof(point<T, N>) == N * sizeof(T),
+                "points are written as interleaved coordinates");
+  void const *coords[] = {points};
+  if (!curve_file_write(path.c_str(), curve_file_type_of<T>(),
+                        static_cast<int>(N),
+                        CURVE_FILE_INTERLEAVED, length, coords))
+    throw std::system_error(errno, std::generic_category(), path);
+}
+
+/**
+ * Saves the points of _c_ to _path_ with the interleaved layout
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void write_curve_file(std::string const &path, curve<T, N> const &c) {
+  write_curve_file(path, c.points().data(), c.length());
+}
+
+/**
+ * Saves the points of _c_ to _path_ with the separate layout
+ */
+template <FLOATING_POINT_CONCEPT T>
+void write_curve_file(std::string const &path, curve_soa<T> const &c) {
+  void const *coords[] = {c.xs().data(), c.ys().data()};
+  if (!curve_file_write(path.c_str(), curve_file_type_of<T>(), 2,
+                        CURVE_FILE_SEPARATE, c.length(), coords))
+    throw std::system_error(errno, std::generic_category(), path);
+}
+
+#endif
@@ -2,13 +2,18 @@
 #define CURVE_PRINT_HPP
 
 #include "curve.hpp"
+#include "curve_soa.hpp"
+#include "decimate.hpp"
+#include "extrema.hpp"
 #include "legacysupport.hpp"
 #include "point.hpp"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <optional>
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 // adapted from processing/p5.js
@@ -19,13 +24,6 @@ T map(T n, T start1, T stop1, T start2, T stop2) {
   return newval;
 }
 
-template <FLOATING_POINT_CONCEPT T> struct extrema {
-  T minx;
-  T miny;
-  T maxx;
-  T maxy;
-};
-
 class curve_print {
 
   bool start_x_0_;
@@ -35,6 +33,19 @@ class curve_print {
   int twidth;
   int theight;
 
+  // the last frame drawn, theight rows of twidth cells each ending in a
+  // newline. It is kept between calls so printing does not allocate once it
+  // has grown to the terminal size.
+  mutable std::string frame_;
+  // what the terminal shows after the last live frame, empty if print_live
+  // has not drawn anything yet, and the escape sequences sent to update it
+  mutable std::string shown_;
+  mutable std::string patch_;
+
+  /**
+   * The smallest and largest x and y values of _c_ found in one pass over
+   * its points, or nothing if it is empty
+   */
   template <FLOATING_POINT_CONCEPT T>
   std::optional<extrema<T>> get_curve_extrema(curve<T> const &c) const {
     if (c.points().size() == 0) {
@@ -42,16 +53,19 @@ class curve_print {
     }
 
     auto const &points_ = c.points();
-    auto [ipminx, ipmaxx] = std::minmax_element(
-        points_.begin(), points_.end(),
-        [](point<T> const &a, point<T> const &b) { return a.x < b.x; });
-
-    auto [ipminy, ipmaxy] = std::minmax_element(
-        points_.begin(), points_.end(),
-        [](point<T> const &a, point<T> const &b) { return a.y < b.y; });
+    extrema<T> e{points_[0].x, points_[0].y, points_[0].x, points_[0].y};
+    for (auto const &p : points_) {
+      e.minx = p.x < e.minx ? p.x : e.minx;
+      e.maxx = p.x > e.maxx ? p.x : e.maxx;
+      e.miny = p.y < e.miny ? p.y : e.miny;
+      e.maxy = p.y > e.maxy ? p.y : e.maxy;
+    }
+    return e;
+  }
 
-    return std::optional{
-        extrema<T>{ipminx->x, ipminy->y, ipmaxx->x, ipmaxy->y}};
+  template <FLOATING_POINT_CONCEPT T>
+  std::optional<extrema<T>> get_curve_extrema(curve_soa<T> const &c) const {
+    return c.get_extrema();
   }
 
   template <FLOATING_POINT_CONCEPT T>
@@ -88,38 +102,143 @@ public:
 
 
   template <FLOATING_POINT_CONCEPT T> void print(curve<T> const &c) const {
-    std::vector<std::vector<char>> screen{};
-    for (int i = 0; i < theight; i++) {
-      screen.emplace_back();
-      for (int j = 0; j < twidth; j++) {
-        screen.back().push_back('-');
-      }
-    }
     auto const &points_ = c.points();
+    render(get_curve_extrema(c), points_.size(),
+           [&points_](std::size_t i) { return points_[i]; });
+  }
 
-    std::optional<extrema<T>> oe = get_curve_extrema(c);
-    if (!oe.has_value()) {
-      out << "No points in curve\n";
+  template <FLOATING_POINT_CONCEPT T> void print(curve_soa<T> const &c) const {
+    render(get_curve_extrema(c), c.length(),
+           [&c](std::size_t i) { return c.at(i); });
+  }
+
+  /**
+   * Draws _c_ as the next frame of a live view that is redrawn in place on
+   * an ANSI terminal. The first frame clears the screen. After that only
+   * the cells that differ from the previous frame are sent, each run of
+   * them after a cursor move, so an update costs what changed rather than
+   * the whole screen. Every frame is sent with one write and leaves the
+   * cursor on the line below it.
+   */
+  template <FLOATING_POINT_CONCEPT T>
+  void print_live(curve<T> const &c) const {
+    auto const &points_ = c.points();
+    render_live(get_curve_extrema(c), points_.size(),
+                [&points_](std::size_t i) { return points_[i]; });
+  }
+
+  template <FLOATING_POINT_CONCEPT T>
+  void print_live(curve_soa<T> const &c) const {
+    render_live(get_curve_extrema(c), c.length(),
+                [&c](std::size_t i) { return c.at(i); });
+  }
+
+  /**
+   * Reduces _c_ to at most about 4 points per column of this printer with
+   * m4_decimate. Printing the result draws exactly the same frame as
+   * printing _c_, so a long curve that is drawn repeatedly only has to be
+   * read once.
+   */
+  template <FLOATING_POINT_CONCEPT T>
+  [[nodiscard]] curve<T> decimate(curve<T> const &c) const {
+    auto oe = get_curve_extrema(c);
+    if (!oe.has_value() || twidth <= 0)
+      return c;
+    auto [minx, maxx] = fix_bounds(oe->minx, oe->maxx, symmetricX, start_x_0_);
+    return curve<T>{m4_decimate(c.points().data(), c.length(),
+                                axis_mapping<T>(minx, maxx, twidth))};
+  }
+
+  /**
+   * Reduces _c_ to two points per column of this printer with
+   * lttb_decimate. The frame it draws is not exactly that of _c_ but
+   * follows its shape.
+   */
+  template <FLOATING_POINT_CONCEPT T>
+  [[nodiscard]] curve<T> decimate_lttb(curve<T> const &c) const {
+    std::size_t count = twidth > 0 ? 2 * static_cast<std::size_t>(twidth) : 0;
+    return curve<T>{lttb_decimate(c.points().data(), c.length(), count)};
+  }
+
+  /**
+   * Makes the next print_live clear the screen and draw the whole frame,
+   * for when something else has written to the terminal
+   */
+  void reset_live() const { shown_.clear(); }
+
+private:
+  /**
+   * Sends what is needed to turn the terminal from shown_ into frame_ and
+   * makes frame_ the new shown_
+   */
+  void write_changes() const;
+
+  /**
+   * Fills frame_ with '-' and ends every row with a newline
+   */
+  void clear_frame() const;
+
+  /**
+   * Marks the cells of frame_ on the line from cell (_x0_, _y0_) to cell
+   * (_x1_, _y1_), counting rows from the bottom
+   */
+  void draw_line(int x0, int y0, int x1, int y1) const;
+
+  /**
+   * Draws the _length_ points returned by pointAt(i) into frame_ with lines
+   * between consecutive points. Points that land in the same cell as the
+   * one before them are skipped, so dense curves cost one multiply per
+   * coordinate and a compare per point.
+   */
+  template <FLOATING_POINT_CONCEPT T, typename PointAt>
+  void rasterize(extrema<T> e, std::size_t length, PointAt pointAt) const {
+    clear_frame();
+    if (twidth <= 0 || theight <= 0)
       return;
-    }
-    extrema<T> e = *oe;
 
     auto [minx, maxx] = fix_bounds(e.minx, e.maxx, symmetricX, start_x_0_);
     auto [miny, maxy] = fix_bounds(e.miny, e.maxy, symmetricY, start_y_0_);
 
-    for (int i = 0; i < points_.size(); i++) {
-      auto const &p = points_[i];
-      T xchar = map(p.x, minx, maxx, 0.0, twidth - 1.0);
-      T ychar = map(p.y, miny, maxy, 0.0, theight - 1.0);
-      screen[theight - ((int)ychar) - 1][(int)xchar] = 'X';
+    // the same placement as map()
+    axis_mapping<T> columns(minx, maxx, twidth);
+    axis_mapping<T> rows(miny, maxy, theight);
+    auto cell = [&](point<T> const &p) {
+      return std::make_pair(columns(p.x), rows(p.y));
+    };
+
+    auto [px, py] = cell(pointAt(0));
+    draw_line(px, py, px, py);
+    for (std::size_t i = 1; i < length; i++) {
+      auto [x, y] = cell(pointAt(i));
+      if (x == px && y == py)
+        continue;
+      draw_line(px, py, x, y);
+      px = x;
+      py = y;
     }
+  }
 
-    for (int i = 0; i < screen.size(); i++) {
-      for (int j = 0; j < screen[i].size(); j++) {
-        out << screen[i][j];
-      }
-      out << '\n';
+  template <FLOATING_POINT_CONCEPT T, typename PointAt>
+  void render(std::optional<extrema<T>> oe, std::size_t length,
+              PointAt pointAt) const {
+    if (!oe.has_value()) {
+      out << "No points in curve\n";
+      return;
     }
+
+    rasterize(*oe, length, pointAt);
+    out.write(frame_.data(), static_cast<std::streamsize>(frame_.size()));
+  }
+
+  template <FLOATING_POINT_CONCEPT T, typename PointAt>
+  void render_live(std::optional<extrema<T>> oe, std::size_t length,
+                   PointAt pointAt) const {
+    // an empty curve is shown as an empty frame so the view stays in place
+    if (oe.has_value())
+      rasterize(*oe, length, pointAt);
+    else
+      clear_frame();
+    write_changes();
   }
 };
 
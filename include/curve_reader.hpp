@@ -0,0 +1,277 @@
+#ifndef CURVE_READER_HPP
+#define CURVE_READER_HPP
+
+#include "curve.hpp"
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+/**
+ * What curve_reader does with a line whose selected columns are missing or
+ * are not numbers
+ */
+enum class malformed_lines {
+  // count the line in curve_reader::malformed() and go on
+  skip,
+  // throw std::invalid_argument naming the line
+  raise
+};
+
+/**
+ * How curve_reader splits lines into columns and which of them it reads
+ */
+struct curve_reader_options {
+  // the column separator, or 0 to split on runs of spaces and tabs
+  char delimiter = 0;
+  // lines starting with this character are ignored, 0 disables comments
+  char comment = '#';
+  // columns are counted from 0
+  int xColumn = 0;
+  int yColumn = 1;
+  // lines to drop from the start of the input before parsing, for headers
+  int skipLines = 0;
+  malformed_lines onMalformed = malformed_lines::skip;
+  // bytes requested from the input per read
+  std::size_t bufferSize = 1 << 20;
+};
+
+/**
+ * Reads points from delimited text such as CSV files or "x y" lines on
+ * stdin.
+ *
+ * The input is read in large blocks and numbers are parsed in place with
+ * std::from_chars, so there are no streams, no locale lookups and no string
+ * per token. Lines that end in the middle of a block are carried over to the
+ * next one. Empty lines and comment lines are ignored silently.
+ *
+ * Points come out in chunks through read(consume) so they can be fed to a
+ * streaming_simplifier with bounded memory, or all at once with read_curve.
+ */
+template <FLOATING_POINT_CONCEPT T = double> class curve_reader {
+public:
+  /**
+   * Reads from _input_, which stays open and owned by the caller
+   */
+  explicit curve_reader(std::FILE *input, curve_reader_options options = {})
+      : input_(input), options_(options),
+        buffer_(std::max<std::size_t>(options.bufferSize, 64)) {}
+
+  /**
+   * Reads every remaining line and calls consume(std::span<point<T> const>)
+   * with up to _chunk_ points at a time, in input order.
+   *
+   * returns: the number of points read
+   */
+  template <typename Consume>
+  std::size_t read(Consume &&consume, std::size_t chunk = 4096) {
+    std::vector<point<T>> points;
+    points.reserve(chunk);
+    std::size_t total = 0;
+
+    auto flush = [&] {
+      if (points.empty())
+        return;
+      consume(std::span<point<T> const>{points});
+      total += points.size();
+      points.clear();
+    };
+
+    each_line([&](char const *first, char const *last) {
+      point<T> p;
+      if (!parse_line(first, last, p))
+        return;
+      points.push_back(p);
+      if (points.size() == chunk)
+        flush();
+    });
+    flush();
+    return total;
+  }
+
+  /**
+   * Reads every remaining line into a curve. Points are kept in input order,
+   * so the input should already be sorted by x.
+   */
+  [[nodiscard]] curve<T> read_curve() {
+    std::vector<point<T>> points;
+    read([&points](std::span<point<T> const> chunk) {
+      points.insert(points.end(), chunk.begin(), chunk.end());
+    });
+    return curve<T>{std::move(points)};
+  }
+
+  /**
+   * The number of lines seen so far, including skipped ones
+   */
+  [[nodiscard]] std::size_t lines() const noexcept { return line_; }
+
+  /**
+   * The number of malformed lines that were skipped
+   */
+  [[nodiscard]] std::size_t malformed() const noexcept { return malformed_; }
+
+private:
+  /**
+   * Calls line(first, last) for every complete line of the input without
+   * its line terminator, reading a block at a time
+   */
+  template <typename Line> void each_line(Line &&line) {
+    std::size_t pending = 0;
+    while (true) {
+      if (pending == buffer_.size())
+        buffer_.resize(buffer_.size() * 2);
+
+      std::size_t got = std::fread(buffer_.data() + pending, 1,
+                                   buffer_.size() - pending, input_);
+      if (got == 0) {
+        if (std::ferror(input_))
+          throw std::system_error(errno, std::generic_category(),
+                                  "reading curve text");
+        break;
+      }
+
+      char const *begin = buffer_.data();
+      char const *end = begin + pending + got;
+      char const *cursor = begin;
+      while (true) {
+        auto const *newline = static_cast<char const *>(
+            std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+        if (newline == nullptr)
+          break;
+        next_line(cursor, newline, line);
+        cursor = newline + 1;
+      }
+
+      pending = static_cast<std::size_t>(end - cursor);
+      std::memmove(buffer_.data(), cursor, pending);
+    }
+
+    // the last line may not end in a newline
+    if (pending > 0)
+      next_line(buffer_.data(), buffer_.data() + pending, line);
+  }
+
+  template <typename Line>
+  void next_line(char const *first, char const *last, Line &line) {
+    line_++;
+    if (line_ <= static_cast<std::size_t>(std::max(options_.skipLines, 0)))
+      return;
+    if (last != first && last[-1] == '\r')
+      last--;
+    line(first, last);
+  }
+
+  static bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+  /**
+   * Parses the x and y columns of one line into _p_, walking the columns
+   * once.
+   * returns: false if the line holds no point
+   */
+  bool parse_line(char const *first, char const *last, point<T> &p) {
+    char const *start = first;
+    while (start != last && is_blank(*start))
+      start++;
+    if (start == last ||
+        (options_.comment != 0 && *start == options_.comment))
+      return false;
+
+    if (parse_columns(start, last, p))
+      return true;
+
+    if (options_.onMalformed == malformed_lines::raise)
+      throw std::invalid_argument("malformed point on line " +
+                                  std::to_string(line_) + ": " +
+                                  std::string(first, last));
+    malformed_++;
+    return false;
+  }
+
+  bool parse_columns(char const *first, char const *last, point<T> &p) const {
+    char delimiter = options_.delimiter;
+    int xColumn = options_.xColumn;
+    int yColumn = options_.yColumn;
+    if (xColumn < 0 || yColumn < 0)
+      return false;
+
+    int lastColumn = std::max(xColumn, yColumn);
+    for (int i = 0;; i++) {
+      while (first != last && is_blank(*first))
+        first++;
+
+      char const *end;
+      if (i == xColumn || i == yColumn) {
+        // the number is parsed where it starts and must fill the column
+        T value;
+        if (first != last && *first == '+')
+          first++;
+        auto [ptr, error] = std::from_chars(first, last, value);
+        if (error != std::errc{})
+          return false;
+        if (i == xColumn)
+          p.x = value;
+        if (i == yColumn)
+          p.y = value;
+
+        end = ptr;
+        while (end != last && is_blank(*end))
+          end++;
+        if (end != last && delimiter != 0 && *end != delimiter)
+          return false;
+        if (end != last && delimiter == 0 && end == ptr)
+          return false;
+      } else if (delimiter == 0) {
+        if (first == last)
+          return false;
+        end = first;
+        while (end != last && !is_blank(*end))
+          end++;
+      } else {
+        end = static_cast<char const *>(std::memchr(
+            first, delimiter, static_cast<std::size_t>(last - first)));
+        if (end == nullptr)
+          end = last;
+      }
+
+      if (i == lastColumn)
+        return true;
+      if (end == last)
+        return false;
+      first = delimiter == 0 ? end : end + 1;
+    }
+  }
+
+  std::FILE *input_;
+  curve_reader_options options_;
+  std::vector<char> buffer_;
+  std::size_t line_ = 0;
+  std::size_t malformed_ = 0;
+};
+
+/**
+ * Reads the curve stored as text in the file at _path_. Throws
+ * std::system_error if the file cannot be opened.
+ */
+template <FLOATING_POINT_CONCEPT T = double>
+[[nodiscard]] curve<T> read_curve_text(std::string const &path,
+                                       curve_reader_options options = {}) {
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(
+      std::fopen(path.c_str(), "rb"), std::fclose);
+  if (!file)
+    throw std::system_error(errno, std::generic_category(), path);
+  return curve_reader<T>(file.get(), options).read_curve();
+}
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef CURVE_SOA_HPP
+#define CURVE_SOA_HPP
+
+#include "curve.hpp"
+#include "extrema.hpp"
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_engine.hpp"
+#include "rdp_kernel.hpp"
+#include "rdp_kernel.h"
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Allocator returning memory aligned to _Align_ bytes so vector loads of the
+ * coordinate arrays never straddle a cache line boundary at the start.
+ */
+template <typename U, std::size_t Align = 64> struct aligned_allocator {
+  using value_type = U;
+
+  template <typename V> struct rebind {
+    using other = aligned_allocator<V, Align>;
+  };
+
+  aligned_allocator() noexcept = default;
+
+  template <typename V>
+  aligned_allocator(aligned_allocator<V, Align> const &) noexcept {}
+
+  [[nodiscard]] U *allocate(std::size_t n) {
+    return static_cast<U *>(
+        ::operator new(n * sizeof(U), std::align_val_t{Align}));
+  }
+
+  void deallocate(U *p, std::size_t) noexcept {
+    ::operator delete(p, std::align_val_t{Align});
+  }
+
+  template <typename V>
+  bool operator==(aligned_allocator<V, Align> const &) const noexcept {
+    return true;
+  }
+};
+
+/**
+ * Same as curve but the x and y coordinates are kept in two separate,
+ * aligned arrays instead of one array of points. Scanning them is unit
+ * stride, so the distance and extrema kernels load full vectors without
+ * shuffling and a pass over only one coordinate reads half the memory.
+ *
+ * Like curve, points should be sorted by their x coordinate.
+ */
+template <FLOATING_POINT_CONCEPT T = double> struct curve_soa {
+  using storage = std::vector<T, aligned_allocator<T>>;
+
+  curve_soa() = default;
+
+  /**
+   * Copies the points of _c_ into separate coordinate arrays
+   */
+  explicit curve_soa(curve<T> const &c) {
+    auto const &points = c.points();
+    xs_.resize(points.size());
+    ys_.resize(points.size());
+    for (std::size_t i = 0; i < points.size(); i++) {
+      xs_[i] = points[i].x;
+      ys_[i] = points[i].y;
+    }
+  }
+
+  /**
+   * Create a curve between startX and endX with a delta
+   * of at most delta and using the function f to get y values
+   */
+  static curve_soa<T> construct(T startX, T endX, T delta, auto f) {
+    std::size_t count = sample_count(startX, endX, delta);
+    curve_soa<T> result;
+    result.xs_.resize(count);
+    result.ys_.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+      T x = sample_at(startX, endX, delta, count, i);
+      result.xs_[i] = x;
+      result.ys_[i] = f(x);
+    }
+    return result;
+  }
+
+  /**
+   * Copies the points back into a curve
+   */
+  [[nodiscard]] curve<T> to_curve() const {
+    std::vector<point<T>> points;
+    points.reserve(length());
+    for (std::size_t i = 0; i < length(); i++)
+      points.emplace_back(xs_[i], ys_[i]);
+    return curve<T>{std::move(points)};
+  }
+
+  [[nodiscard]] storage const &xs() const noexcept { return xs_; }
+
+  [[nodiscard]] storage const &ys() const noexcept { return ys_; }
+
+  [[nodiscard]] auto length() const noexcept { return xs_.size(); }
+
+  [[nodiscard]] point<T> at(std::size_t i) const { return {xs_[i], ys_[i]}; }
+
+  /**
+   * Add a point to the curve. Note that this method does no sorting
+   * and points in the curve should be sorted by their x coordinate.
+   */
+  void addPoint(T x, T y) {
+    xs_.push_back(x);
+    ys_.push_back(y);
+  }
+
+  /**
+   * Add a point to the curve. Note that this method does no sorting
+   * and points in the curve should be sorted by their x coordinate.
+   */
+  void addPoint(point<T> const &p) { addPoint(p.x, p.y); }
+
+  /**
+   * Returns the index of the point between start and end that is furthest
+   * from the line through at(start) and at(end) along with that distance.
+   * The index is -1 if every point is on the line.
+   */
+  [[nodiscard]] auto furthestPoint(int start, int end) const {
+    return furthest_point_soa(xs_.data(), ys_.data(), start, end);
+  }
+
+  /**
+   * Simplify the curve using the Ramer-Douglas-Peuker algorithm. The result
+   * is the same as curve::rdp on the same points.
+   */
+  curve_soa rdp(double epsilon) const {
+    curve_soa result;
+    if (length() == 0)
+      return result;
+
+    T const *xs = xs_.data();
+    T const *ys = ys_.data();
+    std::vector<rdp_span> stack;
+
+    result.addPoint(xs[0], ys[0]);
+    if (length() > 1) {
+      rdp_split_by(
+          0, static_cast<int>(length()) - 1, epsilon, stack,
+          [xs, ys](int s, int e) { return furthest_point_soa(xs, ys, s, e); },
+          [&](int i) { result.addPoint(xs[i], ys[i]); });
+      result.addPoint(xs_.back(), ys_.back());
+    }
+    return result;
+  }
+
+  /**
+   * The smallest and largest x and y values, each found in one unit stride
+   * pass over its own array, or nothing if the curve is empty
+   */
+  [[nodiscard]] std::optional<extrema<T>> get_extrema() const {
+    if (length() == 0)
+      return std::nullopt;
+
+    extrema<T> e;
+    if constexpr (std::is_same_v<T, double>) {
+      int n = static_cast<int>(length());
+      rdp_kernel_minmax(xs_.data(), n, &e.minx, &e.maxx);
+      rdp_kernel_minmax(ys_.data(), n, &e.miny, &e.maxy);
+    } else if constexpr (std::is_same_v<T, float>) {
+      int n = static_cast<int>(length());
+      rdp_kernel_minmax_f32(xs_.data(), n, &e.minx, &e.maxx);
+      rdp_kernel_minmax_f32(ys_.data(), n, &e.miny, &e.maxy);
+    } else {
+      auto [minx, maxx] = std::minmax_element(xs_.begin(), xs_.end());
+      auto [miny, maxy] = std::minmax_element(ys_.begin(), ys_.end());
+      e = {*minx, *miny, *maxx, *maxy};
+    }
+    return e;
+  }
+
+private:
+  storage xs_;
+  storage ys_;
+};
+
+#endif
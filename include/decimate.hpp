@@ -0,0 +1,179 @@
+#ifndef DECIMATE_HPP
+#define DECIMATE_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_kernel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Maps values from _min_ to _max_ onto _cells_ cells numbered from 0, the
+ * way curve_print places points on the screen. Like map() it divides by the
+ * range before scaling to the cells, so _max_ lands exactly in the last
+ * cell, and values outside the range land in the first or last cell.
+ */
+template <FLOATING_POINT_CONCEPT T> struct axis_mapping {
+  // float curves are mapped in double so their cells match double ones
+  using M = rdp_metric_t<T>;
+  M min;
+  M range;
+  int cells;
+
+  axis_mapping(T min, T max, int cells)
+      : min(M(min)), range(M(max) - M(min) == 0 ? 1 : M(max) - M(min)),
+        cells(cells) {}
+
+  [[nodiscard]] int operator()(T v) const {
+    return std::clamp(static_cast<int>((M(v) - min) / range * M(cells - 1)),
+                      0, cells - 1);
+  }
+};
+
+/**
+ * Reduces the _length_ points starting at _points_ to the ones that decide
+ * how they look when drawn as connected lines with _columns_ mapping x to
+ * screen columns. Of every run of consecutive points in one column the
+ * first, the last and the ones with the smallest and largest y are kept,
+ * which is the M4 aggregation, along with the points with the smallest and
+ * largest x so the bounds of the curve do not change.
+ *
+ * Drawing the result with the same mapping for y marks exactly the same
+ * cells as drawing every point: inside a column the kept points span the
+ * same rows, and the lines between columns join the same points. For a
+ * curve sorted by x there is one run per column, so at most 4 points per
+ * column are kept however long the curve is.
+ *
+ * returns: the kept points in their original order
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::vector<point<T>>
+m4_decimate(point<T> const *points, std::size_t length,
+            axis_mapping<T> const &columns) {
+  std::vector<point<T>> result;
+  if (length == 0)
+    return result;
+
+  std::vector<std::size_t> kept;
+  auto flush = [&](std::size_t first, std::size_t last, std::size_t low,
+                   std::size_t high) {
+    std::size_t run[] = {first, std::min(low, high), std::max(low, high),
+                         last};
+    for (std::size_t i : run) {
+      if (kept.empty() || kept.back() != i)
+        kept.push_back(i);
+    }
+  };
+
+  std::size_t minx = 0, maxx = 0;
+  std::size_t first = 0, low = 0, high = 0;
+  int column = columns(points[0].x);
+  for (std::size_t i = 1; i < length; i++) {
+    point<T> const &p = points[i];
+    minx = p.x < points[minx].x ? i : minx;
+    maxx = p.x > points[maxx].x ? i : maxx;
+
+    int c = columns(p.x);
+    if (c == column) {
+      low = p.y < points[low].y ? i : low;
+      high = p.y > points[high].y ? i : high;
+      continue;
+    }
+
+    flush(first, i - 1, low, high);
+    first = low = high = i;
+    column = c;
+  }
+  flush(first, length - 1, low, high);
+
+  // only needed when the curve is not sorted by x
+  for (std::size_t extreme : {minx, maxx}) {
+    auto it = std::lower_bound(kept.begin(), kept.end(), extreme);
+    if (it == kept.end() || *it != extreme)
+      kept.insert(it, extreme);
+  }
+
+  result.reserve(kept.size());
+  for (std::size_t i : kept)
+    result.push_back(points[i]);
+  return result;
+}
+
+/**
+ * Reduces the _length_ points starting at _points_ to _count_ points with
+ * the Largest-Triangle-Three-Buckets algorithm. The first and last points
+ * are kept and the rest are split into count - 2 buckets of consecutive
+ * points. From each bucket the point forming the largest triangle with the
+ * point kept from the bucket before and the average of the bucket after is
+ * kept.
+ *
+ * Unlike m4_decimate this does not draw exactly the same picture, but it
+ * keeps the shape of the curve with a fixed number of points, about one
+ * or two per column of the output.
+ *
+ * returns: the kept points in their original order, or all of them if
+ * there are no more than _count_
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::vector<point<T>>
+lttb_decimate(point<T> const *points, std::size_t length, std::size_t count) {
+  using M = rdp_metric_t<T>;
+  if (length <= count)
+    return std::vector<point<T>>(points, points + length);
+
+  std::vector<point<T>> result;
+  result.reserve(count);
+  if (count == 0)
+    return result;
+  result.push_back(points[0]);
+  if (count == 1)
+    return result;
+  if (count == 2) {
+    result.push_back(points[length - 1]);
+    return result;
+  }
+
+  // bucket b holds the points from bucket_start(b) up to bucket_start(b + 1)
+  std::size_t buckets = count - 2;
+  auto bucket_start = [&](std::size_t b) {
+    return 1 + static_cast<std::size_t>(static_cast<long double>(b) *
+                                        (length - 2) / buckets);
+  };
+
+  std::size_t a = 0;
+  for (std::size_t b = 0; b < buckets; b++) {
+    std::size_t start = bucket_start(b), end = bucket_start(b + 1);
+    std::size_t nextStart = end;
+    std::size_t nextEnd = b + 1 < buckets ? bucket_start(b + 2) : length;
+
+    M cx = 0, cy = 0;
+    for (std::size_t i = nextStart; i < nextEnd; i++) {
+      cx += M(points[i].x);
+      cy += M(points[i].y);
+    }
+    cx /= M(nextEnd - nextStart);
+    cy /= M(nextEnd - nextStart);
+
+    // twice the area, which picks the same point
+    M ax = M(points[a].x), ay = M(points[a].y);
+    M best = -1;
+    std::size_t chosen = start;
+    for (std::size_t i = start; i < end; i++) {
+      M area = std::abs((ax - cx) * (M(points[i].y) - ay) -
+                        (ax - M(points[i].x)) * (cy - ay));
+      if (area > best) {
+        best = area;
+        chosen = i;
+      }
+    }
+    result.push_back(points[chosen]);
+    a = chosen;
+  }
+
+  result.push_back(points[length - 1]);
+  return result;
+}
+
+#endif
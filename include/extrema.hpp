@@ -0,0 +1,18 @@
+#ifndef EXTREMA_HPP
+#define EXTREMA_HPP
+
+#include "legacysupport.hpp"
+#include <type_traits>
+
+/**
+ * The smallest and largest x and y values of a curve. Each coordinate is
+ * found independently, so (minx, miny) need not be a point of the curve.
+ */
+template <FLOATING_POINT_CONCEPT T> struct extrema {
+  T minx;
+  T miny;
+  T maxx;
+  T maxy;
+};
+
+#endif
@@ -2,26 +2,115 @@
 #define POINT_HPP
 
 #include "legacysupport.hpp"
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <concepts>
+#include <cstddef>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
-template <FLOATING_POINT_CONCEPT T = double> struct point {
+/**
+ * Calls f(std::integral_constant<std::size_t, I>{}) for every I from 0 to
+ * N - 1, written out at compile time rather than as a loop
+ */
+template <std::size_t N, typename F> constexpr void unroll(F &&f) {
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (f(std::integral_constant<std::size_t, I>{}), ...);
+  }(std::make_index_sequence<N>{});
+}
+
+/**
+ * A point with _N_ coordinates, for example latitude, longitude and
+ * altitude, or x, y and time. 2D points are a specialization below with
+ * named x and y members, and are what the rest of the library uses unless
+ * asked for another dimension. Coordinates are stored next to each other,
+ * so an array of points is N values per point with no padding.
+ */
+template <FLOATING_POINT_CONCEPT T = double, std::size_t N = 2> struct point {
+  static_assert(N >= 1, "a point needs at least one coordinate");
+  static constexpr std::size_t dimension = N;
+
+  std::array<T, N> coords;
+
+  point() noexcept : coords{} {}
+
+  template <typename... U>
+    requires(sizeof...(U) == N && (std::convertible_to<U, T> && ...))
+  point(U... values) noexcept : coords{static_cast<T>(values)...} {}
+
+  [[nodiscard]] T &operator[](std::size_t i) noexcept { return coords[i]; }
+
+  [[nodiscard]] T const &operator[](std::size_t i) const noexcept {
+    return coords[i];
+  }
+
+  [[nodiscard]] T dot(point const &b) const {
+    T sum = 0;
+    unroll<N>([&](auto i) { sum += coords[i] * b.coords[i]; });
+    return sum;
+  }
+
+  [[nodiscard]] T mag() const { return std::sqrt(dot(*this)); }
+
+  [[nodiscard]] T dist(point const &other) const {
+    return (*this - other).mag();
+  }
+
+  point operator-(point const &other) const {
+    point r;
+    unroll<N>([&](auto i) { r.coords[i] = coords[i] - other.coords[i]; });
+    return r;
+  }
+
+  point operator+(point const &other) const {
+    point r;
+    unroll<N>([&](auto i) { r.coords[i] = coords[i] + other.coords[i]; });
+    return r;
+  }
+
+  point operator*(T rhs) const {
+    point r;
+    unroll<N>([&](auto i) { r.coords[i] = coords[i] * rhs; });
+    return r;
+  }
+
+  point operator/(T rhs) const {
+    point r;
+    unroll<N>([&](auto i) { r.coords[i] = coords[i] / rhs; });
+    return r;
+  }
+};
+
+/**
+ * point{x, y, z} is a point<T, 3> where T is the type of x
+ */
+template <FLOATING_POINT_CONCEPT T, typename... U>
+point(T, U...) -> point<T, 1 + sizeof...(U)>;
+
+template <FLOATING_POINT_CONCEPT T> struct point<T, 2> {
+  static constexpr std::size_t dimension = 2;
+
   T x, y;
 
   point(T x, T y) noexcept : x(x), y(y) {}
 
   point() noexcept : x(0), y(0) {}
 
+  [[nodiscard]] T &operator[](std::size_t i) noexcept { return i == 0 ? x : y; }
+
+  [[nodiscard]] T const &operator[](std::size_t i) const noexcept {
+    return i == 0 ? x : y;
+  }
+
   static point<T> fromangle(double rads) {
-    double x = cos(rads);
-    double y = sin(rads);
-    return point{x, y};
+    return point{static_cast<T>(std::cos(rads)),
+                 static_cast<T>(std::sin(rads))};
   }
 
-  static point<T> fromangle(double rads, double magnitude) {
+  static point<T> fromangle(double rads, T magnitude) {
     return point::fromangle(rads) * magnitude;
   }
 
@@ -53,14 +142,14 @@ template <FLOATING_POINT_CONCEPT T = double> struct point {
     y = y / m;
   }
 
-  point<T> operator/(double rhs) const {
+  point<T> operator/(T rhs) const {
     auto p = copy();
     p.x /= rhs;
     p.y /= rhs;
     return p;
   }
 
-  point<T> operator*(double rhs) const {
+  point<T> operator*(T rhs) const {
     auto p = copy();
     p.x *= rhs;
     p.y *= rhs;
@@ -0,0 +1,73 @@
+#ifndef PREFILTER_HPP
+#define PREFILTER_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "simplify_kernel.hpp"
+#include <cstddef>
+
+/*
+ * Linear time filters for oversampled curves such as GPS tracks. They read
+ * the points once in order and only compare each one with the last point
+ * kept, so they run at about the speed the points can be read and can be
+ * put in front of rdp to shrink its input. Both run kernels from
+ * simplify_kernel.h that the C implementation shares.
+ *
+ * Both keep the first and last points and guarantee that every point they
+ * drop is less than _tolerance_ from a segment between two consecutive
+ * kept points. Running rdp at _epsilon_ on what they keep then leaves every
+ * original point less than _tolerance_ + _epsilon_ from the line through
+ * its kept neighbours, since rdp keeps each of those segments within
+ * _epsilon_ of that line.
+ */
+
+/**
+ * Keeps a point only if it is at least _tolerance_ from the last point
+ * kept, so every dropped point is within _tolerance_ of the kept point
+ * before it. This removes runs of nearly identical points, like those of a
+ * GPS receiver standing still. The indices of the kept points are stored
+ * in _ws_ in ascending order.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void radial_distance_simplify(point<T, N> const *points, int length,
+                              double tolerance, simplify_buffers &ws) {
+  simplify_kernel_call(
+      points,
+      [&](double const *coords, int dimension) {
+        simplify_kernel_radial_distance(coords, dimension, length, tolerance,
+                                        ws.get());
+      },
+      [&](float const *coords, int dimension) {
+        simplify_kernel_radial_distance_f32(coords, dimension, length,
+                                            tolerance, ws.get());
+      });
+}
+
+/**
+ * Keeps the points where the curve leaves a strip around the line from
+ * the last point kept through the next point that differs from it, the
+ * Reumann-Witkam algorithm. The point before the one that leaves the strip
+ * is kept and a new strip starts there.
+ *
+ * The strip is _tolerance_ wide, half on each side, and a point also
+ * leaves it when it goes back along the line. Every dropped point then
+ * lies between the kept ends of its run and less than _tolerance_ from the
+ * segment joining them, which the classic version does not guarantee.
+ * The indices of the kept points are stored in _ws_ in ascending order.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void reumann_witkam_simplify(point<T, N> const *points, int length,
+                             double tolerance, simplify_buffers &ws) {
+  simplify_kernel_call(
+      points,
+      [&](double const *coords, int dimension) {
+        simplify_kernel_reumann_witkam(coords, dimension, length, tolerance,
+                                       ws.get());
+      },
+      [&](float const *coords, int dimension) {
+        simplify_kernel_reumann_witkam_f32(coords, dimension, length,
+                                           tolerance, ws.get());
+      });
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef PROCEDURAL_CURVE_HPP
+#define PROCEDURAL_CURVE_HPP
+
+#include "curve.hpp"
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_engine.hpp"
+#include "rdp_kernel.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * The points curve<T>::construct(start, end, delta, f) would hold, computed
+ * from _f_ when they are read instead of being stored. Simplifying one
+ * evaluates only the points each furthest point scan covers and keeps only
+ * the kept points and the pending ranges, so its memory grows with the
+ * output rather than the input. Indices are 64 bit, so functions can be
+ * sampled far more finely than a curve could store.
+ *
+ * Every scan evaluates f again for the points it covers, about as many calls
+ * as the depth of the split tree times the length. This trades time for
+ * memory and is worth it when the samples would not fit or are only stored
+ * to be simplified.
+ */
+template <FLOATING_POINT_CONCEPT T, typename F> class procedural_curve {
+public:
+  /**
+   * Samples from _start_ to _end_ at most _delta_ apart, with the same
+   * points and the same errors as curve<T>::construct
+   */
+  procedural_curve(T start, T end, T delta, F f)
+      : start_(start), end_(end), delta_(delta),
+        length_(static_cast<std::int64_t>(sample_count(start, end, delta))),
+        f_(std::move(f)) {}
+
+  [[nodiscard]] std::int64_t length() const noexcept { return length_; }
+
+  /**
+   * Evaluates the _i_th point
+   */
+  [[nodiscard]] point<T> at(std::int64_t i) const {
+    T x = x_at(i);
+    return {x, f_(x)};
+  }
+
+  /**
+   * Returns the index of the point between start and end that is furthest
+   * from the line through at(start) and at(end) along with that distance.
+   * The index is -1 if every point is on the line.
+   *
+   * Points are evaluated a block at a time into a buffer on the stack and
+   * measured with the same kernel as a stored curve, so the answer is the
+   * same as curve::furthestPoint on the constructed curve.
+   */
+  [[nodiscard]] std::tuple<std::int64_t, T>
+  furthestPoint(std::int64_t start, std::int64_t end) const {
+    constexpr std::int64_t block = 512;
+    point<T> s = at(start);
+    point<T> e = at(end);
+    point<T> buffer[block];
+
+    std::int64_t furthestIndex = -1;
+    rdp_metric_t<T> record = 0;
+    for (std::int64_t first = start + 1; first < end; first += block) {
+      int n = static_cast<int>(std::min(block, end - first));
+      for (int j = 0; j < n; j++)
+        buffer[j] = at(first + j);
+
+      rdp_metric_t<T> metric;
+      int j = argmax_metric(buffer, 0, n, s, e, metric);
+      if (j != -1 && metric > record) {
+        furthestIndex = first + j;
+        record = metric;
+      }
+    }
+
+    if (furthestIndex == -1)
+      return std::make_tuple(std::int64_t{-1}, T{0});
+    return std::make_tuple(furthestIndex,
+                           static_cast<T>(metric_distance(s, e, record)));
+  }
+
+  /**
+   * Simplify the curve using the Ramer-Douglas-Peuker algorithm without
+   * storing its points. The result is the same as
+   * curve<T>::construct(start, end, delta, f).rdp(epsilon).
+   */
+  [[nodiscard]] curve<T> rdp(double epsilon) const {
+    std::vector<point<T>> kept;
+    for_each_kept(epsilon, [&](std::int64_t i) { kept.push_back(at(i)); });
+    return curve<T>{std::move(kept)};
+  }
+
+  /**
+   * Same as rdp(double) but only returns the indices of the kept points in
+   * ascending order
+   */
+  [[nodiscard]] std::vector<std::int64_t> rdp_indices(double epsilon) const {
+    std::vector<std::int64_t> kept;
+    for_each_kept(epsilon, [&](std::int64_t i) { kept.push_back(i); });
+    return kept;
+  }
+
+  /**
+   * Evaluates and stores every point. This is what construct returns.
+   */
+  [[nodiscard]] curve<T> to_curve() const {
+    return curve<T>::construct(start_, end_, delta_, f_);
+  }
+
+private:
+  T start_, end_, delta_;
+  std::int64_t length_;
+  F f_;
+
+  [[nodiscard]] T x_at(std::int64_t i) const {
+    return sample_at(start_, end_, delta_, static_cast<std::size_t>(length_),
+                     static_cast<std::size_t>(i));
+  }
+
+  template <typename Keep> void for_each_kept(double epsilon, Keep &&keep) const {
+    keep(0);
+    if (length_ < 2)
+      return;
+
+    std::vector<rdp_basic_span<std::int64_t>> stack;
+    rdp_split_by(
+        std::int64_t{0}, length_ - 1, epsilon, stack,
+        [this](std::int64_t s, std::int64_t e) { return furthestPoint(s, e); },
+        keep);
+    keep(length_ - 1);
+  }
+};
+
+template <FLOATING_POINT_CONCEPT T, typename F>
+procedural_curve(T, T, T, F) -> procedural_curve<T, F>;
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef RDP_BATCH_H
+#define RDP_BATCH_H
+
+#include "curve.h"
+#include "point.h"
+#include <stddef.h>
+
+/**
+ * Simplifies _count_ polylines stored back to back in _points_ with the
+ * Ramer-Douglas-Peuker algorithm. Polyline i is made of the points from
+ * offsets[i] up to, not including, offsets[i + 1], so _offsets_ holds
+ * count + 1 entries.
+ *
+ * The indices into _points_ of the points kept from polyline i are written
+ * to kept_indices[kept_offsets[i]] up to kept_indices[kept_offsets[i + 1]].
+ * _kept_indices_ must have room for offsets[count] entries and
+ * _kept_offsets_ for count + 1.
+ *
+ * The polylines are split between _threads_ threads, each of which reuses
+ * one rdp_workspace for all of its polylines, so nothing is allocated per
+ * polyline. The output does not depend on the number of threads.
+ *
+ * returns: the total number of kept points
+ */
+size_t rdp_batch(point const *points, size_t const *offsets, size_t count,
+                 double epsilon, size_t *kept_indices, size_t *kept_offsets,
+                 int threads);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef RDP_BATCH_HPP
+#define RDP_BATCH_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_engine.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Simplifies the polylines [first, last) of a batch and writes the kept
+ * indices of polyline i to keptIndices[offsets[i]...], which always has room
+ * because a polyline never keeps more points than it has. The number kept
+ * is stored in keptOffsets[i + 1].
+ */
+template <FLOATING_POINT_CONCEPT T>
+void rdp_batch_range(point<T> const *points, std::size_t const *offsets,
+                     std::size_t first, std::size_t last, double epsilon,
+                     std::size_t *keptIndices, std::size_t *keptOffsets) {
+  // reused by every polyline this thread simplifies
+  thread_local std::vector<rdp_span> stack;
+
+  for (std::size_t i = first; i < last; i++) {
+    std::size_t begin = offsets[i];
+    int length = static_cast<int>(offsets[i + 1] - begin);
+    std::size_t *out = keptIndices + begin;
+    std::size_t kept = 0;
+
+    if (length > 0)
+      out[kept++] = begin;
+    if (length > 1) {
+      rdp_split(points + begin, 0, length - 1, epsilon, stack,
+                [&](int k) { out[kept++] = begin + k; });
+      out[kept++] = begin + length - 1;
+    }
+    keptOffsets[i + 1] = kept;
+  }
+}
+
+/**
+ * Moves the kept indices of every polyline next to each other and turns the
+ * counts in keptOffsets into offsets. Each polyline's output only moves
+ * towards the front so this can be done in place in one pass.
+ */
+inline std::size_t rdp_batch_compact(std::size_t const *offsets,
+                                     std::size_t count,
+                                     std::size_t *keptIndices,
+                                     std::size_t *keptOffsets) {
+  keptOffsets[0] = 0;
+  for (std::size_t i = 0; i < count; i++) {
+    std::size_t kept = keptOffsets[i + 1];
+    if (keptOffsets[i] != offsets[i])
+      std::copy(keptIndices + offsets[i], keptIndices + offsets[i] + kept,
+                keptIndices + keptOffsets[i]);
+    keptOffsets[i + 1] = keptOffsets[i] + kept;
+  }
+  return keptOffsets[count];
+}
+
+/**
+ * Simplifies _count_ polylines stored back to back in _points_ with the
+ * Ramer-Douglas-Peuker algorithm. Polyline i is made of the points from
+ * offsets[i] up to, not including, offsets[i + 1], so _offsets_ holds
+ * count + 1 entries.
+ *
+ * The indices into _points_ of the points kept from polyline i are written
+ * to keptIndices[keptOffsets[i]] up to keptIndices[keptOffsets[i + 1]].
+ * _keptIndices_ must have room for offsets[count] entries and _keptOffsets_
+ * for count + 1. Nothing is allocated per polyline.
+ *
+ * returns: the total number of kept points
+ */
+template <FLOATING_POINT_CONCEPT T>
+std::size_t rdp_batch(point<T> const *points, std::size_t const *offsets,
+                      std::size_t count, double epsilon,
+                      std::size_t *keptIndices, std::size_t *keptOffsets) {
+  rdp_batch_range(points, offsets, 0, count, epsilon, keptIndices,
+                  keptOffsets);
+  return rdp_batch_compact(offsets, count, keptIndices, keptOffsets);
+}
+
+/**
+ * Same as rdp_batch but the polylines are divided into tasks of roughly
+ * _pointsPerTask_ points each that run on _executor_. The output is the same
+ * as the serial version.
+ */
+template <FLOATING_POINT_CONCEPT T>
+std::size_t rdp_batch(point<T> const *points, std::size_t const *offsets,
+                      std::size_t count, double epsilon,
+                      std::size_t *keptIndices, std::size_t *keptOffsets,
+                      thread_pool &executor,
+                      std::size_t pointsPerTask = 1 << 16) {
+  {
+    task_group group(executor);
+    std::size_t first = 0;
+    while (first < count) {
+      std::size_t last = first + 1;
+      while (last < count && offsets[last] - offsets[first] < pointsPerTask)
+        last++;
+      group.run([=] {
+        rdp_batch_range(points, offsets, first, last, epsilon, keptIndices,
+                        keptOffsets);
+      });
+      first = last;
+    }
+    group.wait();
+  }
+  return rdp_batch_compact(offsets, count, keptIndices, keptOffsets);
+}
+
+#endif
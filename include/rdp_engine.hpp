@@ -0,0 +1,338 @@
+#ifndef RDP_ENGINE_HPP
+#define RDP_ENGINE_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_kernel.hpp"
+#include "rdp_stats.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A pending range of a curve during simplification. When emitStart is set
+ * the start point was kept by the split that created this range and is
+ * output before the range is scanned, which keeps the output in the same
+ * order as a recursive implementation. _Index_ is wider than int only for
+ * curves that are never stored, see procedural_curve.hpp.
+ */
+template <typename Index> struct rdp_basic_span {
+  Index start, end;
+  bool emitStart;
+};
+
+using rdp_span = rdp_basic_span<int>;
+
+/**
+ * Runs the Ramer-Douglas-Peuker algorithm over the indices strictly between
+ * _start_ and _end_ and calls keep(index) for every index it keeps, in
+ * ascending order. The endpoints themselves are not reported.
+ *
+ * furthest(s, e) must return a tuple of the index of the point between s and
+ * e that is furthest from the line through them, or -1 if there is none, and
+ * that distance. This lets any point storage use the same engine.
+ *
+ * Instead of recursing once per split this keeps the pending ranges on
+ * _stack_ so inputs that split into very deep trees, such as spirals, cannot
+ * overflow the call stack. _stack_ is empty again when this returns.
+ *
+ * _stats_ is told about every scan and the depth of the stack, see
+ * rdp_stats.hpp. Passing rdp_no_stats compiles the hooks away.
+ */
+template <typename Index, typename Furthest, typename Keep, typename Stats>
+void rdp_split_by(Index start, Index end, double epsilon,
+                  std::vector<rdp_basic_span<Index>> &stack,
+                  Furthest &&furthest, Keep &&keep, Stats &stats) {
+  stack.push_back({start, end, false});
+  while (!stack.empty()) {
+    auto s = stack.back();
+    stack.pop_back();
+
+    if (s.emitStart)
+      keep(s.start);
+
+    if (s.end - s.start < 2)
+      continue;
+
+    auto [furthestIdx, d] =
+        stats.scan(s.start, s.end, [&] { return furthest(s.start, s.end); });
+    if (furthestIdx == -1 || d < epsilon)
+      continue;
+
+    // the left range is pushed last so it is finished first
+    stack.push_back({furthestIdx, s.end, true});
+    stack.push_back({s.start, furthestIdx, false});
+    stats.depth(stack.size());
+  }
+}
+
+template <typename Index, typename Furthest, typename Keep>
+void rdp_split_by(Index start, Index end, double epsilon,
+                  std::vector<rdp_basic_span<Index>> &stack,
+                  Furthest &&furthest, Keep &&keep) {
+  rdp_no_stats stats;
+  rdp_split_by(start, end, epsilon, stack, std::forward<Furthest>(furthest),
+               std::forward<Keep>(keep), stats);
+}
+
+/**
+ * rdp_split_by for an array of points of any dimension
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N, typename Keep,
+          typename Stats>
+void rdp_split(point<T, N> const *points, int start, int end, double epsilon,
+               std::vector<rdp_span> &stack, Keep &&keep, Stats &stats) {
+  rdp_split_by(
+      start, end, epsilon, stack,
+      [points](int s, int e) { return furthest_point(points, s, e); },
+      std::forward<Keep>(keep), stats);
+}
+
+template <FLOATING_POINT_CONCEPT T, std::size_t N, typename Keep>
+void rdp_split(point<T, N> const *points, int start, int end, double epsilon,
+               std::vector<rdp_span> &stack, Keep &&keep) {
+  rdp_no_stats stats;
+  rdp_split(points, start, end, epsilon, stack, std::forward<Keep>(keep),
+            stats);
+}
+
+/**
+ * Keeps at most _count_ of the points with indices 0 to _last_ by greedy
+ * refinement: starting from the two endpoints, the range whose furthest
+ * point deviates the most is always split next. The indices of the kept
+ * points are stored in _kept_ in ascending order.
+ *
+ * furthest(s, e) has the same meaning as for rdp_split_by. Every range is
+ * scanned once when it is created and waits in a priority queue keyed by its
+ * deviation, so this is a single pass rather than a search over epsilon.
+ *
+ * returns: the largest distance of a dropped point from the simplified
+ * curve, or 0 if no point off the curve was dropped
+ */
+template <typename Furthest>
+double rdp_refine_by(int last, int count, Furthest &&furthest,
+                     std::vector<int> &kept) {
+  struct pending {
+    double distance;
+    int start, end, split;
+
+    // the largest deviation first and the leftmost range on ties
+    bool operator<(pending const &other) const {
+      if (distance != other.distance)
+        return distance < other.distance;
+      return start > other.start;
+    }
+  };
+
+  kept.clear();
+  if (last < 0 || count <= 0)
+    return 0;
+
+  kept.push_back(0);
+  if (last == 0 || count == 1)
+    return 0;
+  kept.push_back(last);
+
+  std::priority_queue<pending> queue;
+  auto scan = [&](int s, int e) {
+    if (e - s < 2)
+      return;
+    auto [furthestIdx, d] = furthest(s, e);
+    if (furthestIdx != -1)
+      queue.push({static_cast<double>(d), s, e, furthestIdx});
+  };
+
+  scan(0, last);
+  while (static_cast<int>(kept.size()) < count && !queue.empty()) {
+    auto p = queue.top();
+    queue.pop();
+    kept.push_back(p.split);
+    scan(p.start, p.split);
+    scan(p.split, p.end);
+  }
+
+  std::sort(kept.begin(), kept.end());
+  return queue.empty() ? 0 : queue.top().distance;
+}
+
+class thread_pool;
+
+/**
+ * Ranges with fewer points than this are simplified inline by the task that
+ * reaches them rather than being split into more tasks
+ */
+inline constexpr int rdp_default_task_cutoff = 1 << 14;
+
+/**
+ * Scans over at least this many points are split across the threads of the
+ * executor instead of being run by a single task
+ */
+inline constexpr int rdp_default_scan_cutoff = 1 << 20;
+
+template <FLOATING_POINT_CONCEPT T = double, std::size_t N = 2>
+class rdp_workspace;
+
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void rdp_simplify(point<T, N> const *points, int length, double epsilon,
+                  rdp_workspace<T, N> &ws);
+
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void rdp_simplify_indices(point<T, N> const *points, int length,
+                          double epsilon, rdp_workspace<T, N> &ws);
+
+template <FLOATING_POINT_CONCEPT T>
+void rdp_simplify(point<T> const *points, int length, double epsilon,
+                  thread_pool &executor, rdp_workspace<T> &ws,
+                  int cutoff = rdp_default_task_cutoff,
+                  int scanCutoff = rdp_default_scan_cutoff);
+
+/**
+ * Holds the buffers used by rdp_simplify between calls. Passing the same
+ * workspace to repeated simplifications means nothing is allocated once the
+ * buffers have grown to fit the largest input.
+ *
+ * The results of the last simplification stay available through indices()
+ * and points() until the workspace is used again.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N> class rdp_workspace {
+public:
+  /**
+   * Indices into the input of the points kept by the last simplification in
+   * ascending order
+   */
+  [[nodiscard]] std::vector<int> const &indices() const noexcept {
+    return indices_;
+  }
+
+  /**
+   * The points kept by the last simplification in the same order as indices()
+   */
+  [[nodiscard]] std::vector<point<T, N>> const &points() const noexcept {
+    return points_;
+  }
+
+  /**
+   * Grows the buffers ahead of time so that simplifying up to _length_ points
+   * never allocates
+   */
+  void reserve(std::size_t length) {
+    stack_.reserve(length);
+    indices_.reserve(length);
+    points_.reserve(length);
+  }
+
+  /**
+   * Moves the kept indices out of the workspace. The next simplification
+   * will have to allocate them again.
+   */
+  [[nodiscard]] std::vector<int> take_indices() noexcept {
+    return std::move(indices_);
+  }
+
+  /**
+   * Moves the kept points out of the workspace. The next simplification will
+   * have to allocate them again.
+   */
+  [[nodiscard]] std::vector<point<T, N>> take_points() noexcept {
+    return std::move(points_);
+  }
+
+  /**
+   * The bytes held by the buffers, for reporting how much a run allocated
+   */
+  [[nodiscard]] std::size_t capacity_bytes() const noexcept {
+    return stack_.capacity() * sizeof(rdp_span) +
+           indices_.capacity() * sizeof(int) +
+           points_.capacity() * sizeof(point<T, N>) + mask_.capacity();
+  }
+
+private:
+  std::vector<rdp_span> stack_;
+  std::vector<int> indices_;
+  std::vector<point<T, N>> points_;
+  // which points are kept, only used when simplifying in parallel
+  std::vector<unsigned char> mask_;
+
+  template <FLOATING_POINT_CONCEPT U, std::size_t M, typename Stats>
+  friend void rdp_simplify_indices(point<U, M> const *points, int length,
+                                   double epsilon, rdp_workspace<U, M> &ws,
+                                   Stats &stats);
+
+  template <FLOATING_POINT_CONCEPT U, std::size_t M, typename Stats>
+  friend void rdp_simplify(point<U, M> const *points, int length,
+                           double epsilon, rdp_workspace<U, M> &ws,
+                           Stats &stats);
+
+  friend void rdp_simplify<T>(point<T> const *points, int length,
+                              double epsilon, thread_pool &executor,
+                              rdp_workspace<T> &ws, int cutoff,
+                              int scanCutoff);
+};
+
+/**
+ * Simplifies the _length_ points starting at _points_ using the
+ * Ramer-Douglas-Peuker algorithm and stores only the indices of the kept
+ * points in _ws_. ws.points() is left empty. _stats_ is the stats policy,
+ * see rdp_stats.hpp.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N, typename Stats>
+void rdp_simplify_indices(point<T, N> const *points, int length,
+                          double epsilon, rdp_workspace<T, N> &ws,
+                          Stats &stats) {
+  std::size_t capacity = ws.capacity_bytes();
+  ws.stack_.clear();
+  ws.indices_.clear();
+  ws.points_.clear();
+
+  if (length == 0)
+    return;
+
+  stats.phase(rdp_phase::split, [&] {
+    ws.indices_.push_back(0);
+    if (length > 1) {
+      rdp_split(
+          points, 0, length - 1, epsilon, ws.stack_,
+          [&ws](int i) { ws.indices_.push_back(i); }, stats);
+      ws.indices_.push_back(length - 1);
+    }
+  });
+  stats.kept(ws.indices_.size());
+  stats.allocated(ws.capacity_bytes() - capacity);
+}
+
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void rdp_simplify_indices(point<T, N> const *points, int length,
+                          double epsilon, rdp_workspace<T, N> &ws) {
+  rdp_no_stats stats;
+  rdp_simplify_indices(points, length, epsilon, ws, stats);
+}
+
+/**
+ * Simplifies the _length_ points starting at _points_ using the
+ * Ramer-Douglas-Peuker algorithm and stores the kept indices and copies of
+ * the kept points in _ws_. _stats_ is the stats policy, see rdp_stats.hpp.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N, typename Stats>
+void rdp_simplify(point<T, N> const *points, int length, double epsilon,
+                  rdp_workspace<T, N> &ws, Stats &stats) {
+  rdp_simplify_indices(points, length, epsilon, ws, stats);
+
+  std::size_t capacity = ws.capacity_bytes();
+  stats.phase(rdp_phase::gather, [&] {
+    for (int i : ws.indices_)
+      ws.points_.push_back(points[i]);
+  });
+  stats.allocated(ws.capacity_bytes() - capacity);
+}
+
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+void rdp_simplify(point<T, N> const *points, int length, double epsilon,
+                  rdp_workspace<T, N> &ws) {
+  rdp_no_stats stats;
+  rdp_simplify(points, length, epsilon, ws, stats);
+}
+
+#endif
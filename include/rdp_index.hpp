@@ -0,0 +1,184 @@
+#ifndef RDP_INDEX_HPP
+#define RDP_INDEX_HPP
+
+#include "curve.hpp"
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_kernel.hpp"
+#include "rdp_result.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Records, for every point of a curve, the largest epsilon at which the
+ * Ramer-Douglas-Peuker algorithm still keeps it. A point is kept at epsilon
+ * if its own split distance and the split distance of every split above it
+ * is at least epsilon, so its significance is the smallest of those.
+ *
+ * Building runs RDP once down to the last split. Afterwards simplify(epsilon)
+ * walks only the part of the split tree that is kept and top_k(k) reads a
+ * precomputed ordering, so neither measures a single distance.
+ *
+ * The index stores indices only and does not refer to the curve it was built
+ * from. It stays valid for as long as those points are not changed.
+ */
+template <FLOATING_POINT_CONCEPT T = double> class rdp_index {
+public:
+  rdp_index() = default;
+
+  explicit rdp_index(curve<T> const &c)
+      : rdp_index(c.points().data(), static_cast<int>(c.length())) {}
+
+  /**
+   * Builds the index for the _length_ points starting at _points_
+   */
+  rdp_index(point<T> const *points, int length) { build(points, length); }
+
+  /**
+   * The number of points in the curve the index was built from
+   */
+  [[nodiscard]] int length() const noexcept {
+    return static_cast<int>(significance_.size());
+  }
+
+  /**
+   * The largest epsilon at which point _i_ is kept. This is infinity for
+   * the endpoints and 0 for points RDP never keeps because they lie on the
+   * line through their neighbours.
+   */
+  [[nodiscard]] T significance(int i) const { return significance_[i]; }
+
+  /**
+   * The number of points kept with an epsilon of 0, which is the most any
+   * query can return
+   */
+  [[nodiscard]] int max_kept() const noexcept {
+    return static_cast<int>(order_.size());
+  }
+
+  /**
+   * The indices, in ascending order, of the points curve::rdp(epsilon) keeps
+   */
+  [[nodiscard]] std::vector<int> simplify(double epsilon) const {
+    std::vector<int> out;
+    int n = length();
+    if (n == 0)
+      return out;
+
+    out.push_back(0);
+    // in order walk of the split tree that never descends below a node
+    // whose significance is under epsilon, since nothing there is kept
+    std::vector<int> stack;
+    int node = root_;
+    while (node != -1 || !stack.empty()) {
+      while (node != -1 && significance_[node] >= epsilon) {
+        stack.push_back(node);
+        node = left_[node];
+      }
+      if (stack.empty())
+        break;
+      node = stack.back();
+      stack.pop_back();
+      out.push_back(node);
+      node = right_[node];
+    }
+    if (n > 1)
+      out.push_back(n - 1);
+    return out;
+  }
+
+  /**
+   * The indices, in ascending order, of the _k_ most significant points.
+   * Ties are broken towards points split earlier so a point is never chosen
+   * without the split that exposed it. Fewer than _k_ indices are returned
+   * if the curve has fewer than _k_ points that RDP would ever keep.
+   */
+  [[nodiscard]] std::vector<int> top_k(int k) const {
+    k = std::clamp(k, 0, max_kept());
+    std::vector<int> out(order_.begin(), order_.begin() + k);
+    std::sort(out.begin(), out.end());
+    return out;
+  }
+
+  /**
+   * The points curve::rdp(epsilon) keeps read through _c_, which must be the
+   * curve this index was built from
+   */
+  [[nodiscard]] curve_view<T> view(curve<T> const &c, double epsilon) const {
+    return curve_view<T>{std::span<point<T> const>{c.points()},
+                         simplify(epsilon)};
+  }
+
+private:
+  void build(point<T> const *points, int length) {
+    constexpr T infinity = std::numeric_limits<T>::infinity();
+
+    significance_.assign(length, T{0});
+    left_.assign(length, -1);
+    right_.assign(length, -1);
+    order_.clear();
+    root_ = -1;
+    if (length == 0)
+      return;
+
+    std::vector<int> depth(length, 0);
+    significance_[0] = infinity;
+    significance_[length - 1] = infinity;
+    order_.push_back(0);
+    if (length > 1)
+      order_.push_back(length - 1);
+
+    // each pending range remembers which node it hangs off and on which side
+    struct range {
+      int start, end, parent;
+      bool right;
+    };
+    std::vector<range> stack;
+    stack.push_back({0, length - 1, -1, false});
+    while (!stack.empty()) {
+      auto r = stack.back();
+      stack.pop_back();
+
+      if (r.end - r.start < 2)
+        continue;
+
+      auto [furthestIdx, d] = furthest_point(points, r.start, r.end);
+      if (furthestIdx == -1)
+        continue;
+
+      if (r.parent == -1) {
+        root_ = furthestIdx;
+        significance_[furthestIdx] = d;
+      } else {
+        (r.right ? right_ : left_)[r.parent] = furthestIdx;
+        significance_[furthestIdx] = std::min(d, significance_[r.parent]);
+        depth[furthestIdx] = depth[r.parent] + 1;
+      }
+      order_.push_back(furthestIdx);
+
+      stack.push_back({furthestIdx, r.end, furthestIdx, true});
+      stack.push_back({r.start, furthestIdx, furthestIdx, false});
+    }
+
+    std::sort(order_.begin(), order_.end(), [&](int a, int b) {
+      if (significance_[a] != significance_[b])
+        return significance_[a] > significance_[b];
+      if (depth[a] != depth[b])
+        return depth[a] < depth[b];
+      return a < b;
+    });
+  }
+
+  std::vector<T> significance_;
+  std::vector<int> left_;
+  std::vector<int> right_;
+  // every point RDP can keep, most significant first
+  std::vector<int> order_;
+  int root_ = -1;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef RDP_KERNEL_H
+#define RDP_KERNEL_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The instruction sets the furthest point and extrema kernels can run on. The
+ * best one supported by the running CPU is selected once when the program
+ * loads.
+ */
+enum rdp_kernel_isa {
+  RDP_KERNEL_SCALAR,
+  RDP_KERNEL_SSE2,
+  RDP_KERNEL_AVX2,
+  RDP_KERNEL_AVX512
+};
+
+/**
+ * Constants of the segment a furthest point scan measures against. They are
+ * computed once per scan by rdp_segment_init so the per point work is a
+ * single cross product.
+ *
+ * len2 is the squared length of the segment. When it is 0 the segment is a
+ * single point and distances are measured to (sx, sy) instead.
+ */
+struct rdp_segment {
+  double sx, sy, dx, dy, len2;
+};
+
+/**
+ * Fills in _seg_ for the segment from (sx, sy) to (ex, ey)
+ * Do not pass NULL to _seg_
+ */
+void rdp_segment_init(struct rdp_segment *seg, double sx, double sy, double ex,
+                      double ey);
+
+/**
+ * Converts a metric returned by rdp_kernel_argmax into the perpendicular
+ * distance from the segment.
+ */
+double rdp_segment_distance(struct rdp_segment const *seg, double metric);
+
+/**
+ * Finds the point furthest from _seg_ among the interleaved x/y pairs of _xy_
+ * with indices in [first, last). Only points whose distance is greater than 0
+ * are considered and when several points are equally far the lowest index
+ * wins, which is the same answer as a serial scan using `>`.
+ *
+ * returns: the index of the furthest point or -1 if there is none. In the
+ * first case the value pointed to by _metric_ is set to the squared cross
+ * product of that point (or its squared distance from the start if the
+ * segment is degenerate). It is not modified otherwise.
+ * Warning: _metric_ cannot be NULL
+ */
+int rdp_kernel_argmax(double const *xy, int first, int last,
+                      struct rdp_segment const *seg, double *metric);
+
+/**
+ * Same as rdp_kernel_argmax for points stored as separate arrays of x and y
+ * coordinates, which the vector units can load without shuffling.
+ */
+int rdp_kernel_argmax_soa(double const *xs, double const *ys, int first,
+                          int last, struct rdp_segment const *seg,
+                          double *metric);
+
+/**
+ * Stores the smallest and largest of the _length_ values in _min_ and _max_.
+ * Nothing is stored if _length_ is 0. The values must not be NaN.
+ */
+void rdp_kernel_minmax(double const *values, int length, double *min,
+                       double *max);
+
+/**
+ * Same as rdp_kernel_argmax for points stored as interleaved floats. Every
+ * coordinate is widened to double before it is used and the segment stays in
+ * double, so the result is exactly what rdp_kernel_argmax returns for the
+ * same coordinates stored as doubles, while reading half the memory.
+ */
+int rdp_kernel_argmax_f32(float const *xy, int first, int last,
+                          struct rdp_segment const *seg, double *metric);
+
+/**
+ * Same as rdp_kernel_argmax_soa for coordinates stored as floats, with the
+ * same guarantee as rdp_kernel_argmax_f32
+ */
+int rdp_kernel_argmax_soa_f32(float const *xs, float const *ys, int first,
+                              int last, struct rdp_segment const *seg,
+                              double *metric);
+
+/**
+ * Same as rdp_kernel_minmax for floats. Each vector holds twice as many
+ * floats as doubles.
+ */
+void rdp_kernel_minmax_f32(float const *values, int length, float *min,
+                           float *max);
+
+/**
+ * returns: the instruction set the kernels currently use
+ */
+enum rdp_kernel_isa rdp_kernel_get_isa(void);
+
+/**
+ * Forces the kernels to use _isa_. This exists for benchmarking and must not
+ * be called while other threads are running the kernels.
+ *
+ * returns: false, leaving the kernel unchanged, if the CPU does not support
+ * _isa_ and true otherwise
+ */
+bool rdp_kernel_set_isa(enum rdp_kernel_isa isa);
+
+/**
+ * returns: a printable name for _isa_
+ */
+char const *rdp_kernel_isa_name(enum rdp_kernel_isa isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
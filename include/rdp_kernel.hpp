@@ -0,0 +1,233 @@
+#ifndef RDP_KERNEL_HPP
+#define RDP_KERNEL_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_kernel.h"
+#include <cmath>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * The type distances are computed in for points of type T. Float points are
+ * only a storage format: they are widened to double as they are read, since
+ * the squared cross products lose too many digits in float to tell close
+ * points apart. Long double is computed in long double.
+ */
+template <FLOATING_POINT_CONCEPT T>
+using rdp_metric_t = std::conditional_t<std::is_same_v<T, float>, double, T>;
+
+/**
+ * Finds the point in points[first, last) furthest from the line through _s_
+ * and _e_. Distances are compared as squared cross products against the
+ * segment so no square roots are taken inside the scan. For double and float
+ * this runs the vectorized kernels from rdp_kernel.h, other types use the
+ * same formula in a plain loop.
+ *
+ * returns: the index of the furthest point, the lowest one on ties, or -1 if
+ * no point lies off the line. _metric_ is set to the squared cross product
+ * of the furthest point and can be turned into a distance with
+ * metric_distance. It is not modified if -1 is returned.
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] int argmax_metric(point<T> const *points, int first, int last,
+                                point<T> const &s, point<T> const &e,
+                                rdp_metric_t<T> &metric) {
+  if constexpr (std::is_same_v<T, double>) {
+    static_assert(sizeof(point<double>) == 2 * sizeof(double),
+                  "the kernel reads points as interleaved x/y pairs");
+    rdp_segment seg;
+    rdp_segment_init(&seg, s.x, s.y, e.x, e.y);
+    return rdp_kernel_argmax(reinterpret_cast<double const *>(points), first,
+                             last, &seg, &metric);
+  } else if constexpr (std::is_same_v<T, float>) {
+    static_assert(sizeof(point<float>) == 2 * sizeof(float),
+                  "the kernel reads points as interleaved x/y pairs");
+    rdp_segment seg;
+    rdp_segment_init(&seg, s.x, s.y, e.x, e.y);
+    return rdp_kernel_argmax_f32(reinterpret_cast<float const *>(points),
+                                 first, last, &seg, &metric);
+  } else {
+    T dx = e.x - s.x;
+    T dy = e.y - s.y;
+    T len2 = dx * dx + dy * dy;
+
+    int furthestIndex = -1;
+    T record = 0;
+    for (int i = first; i < last; i++) {
+      T rx = points[i].x - s.x;
+      T ry = points[i].y - s.y;
+      T c = rx * dy - ry * dx;
+      T m = len2 == 0 ? rx * rx + ry * ry : c * c;
+      if (m > record) {
+        furthestIndex = i;
+        record = m;
+      }
+    }
+    if (furthestIndex != -1)
+      metric = record;
+    return furthestIndex;
+  }
+}
+
+/**
+ * Converts a metric found by argmax_metric for the segment from _s_ to _e_
+ * into a distance
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] rdp_metric_t<T> metric_distance(point<T> const &s,
+                                              point<T> const &e,
+                                              rdp_metric_t<T> metric) {
+  using M = rdp_metric_t<T>;
+  M dx = M(e.x) - M(s.x);
+  M dy = M(e.y) - M(s.y);
+  M len2 = dx * dx + dy * dy;
+  return len2 == 0 ? std::sqrt(metric) : std::sqrt(metric / len2);
+}
+
+/**
+ * Returns the index of the point in points[start + 1, end) furthest from the
+ * line through points[start] and points[end] together with that distance.
+ * The index is -1 if no point lies off the line. On ties the lowest index is
+ * returned.
+ *
+ * For float points the index is exactly what the double version returns for
+ * the same points widened to double. Only the returned distance is rounded
+ * to float.
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::tuple<int, T> furthest_point(point<T> const *points,
+                                                int start, int end) {
+  point<T> const &s = points[start];
+  point<T> const &e = points[end];
+
+  rdp_metric_t<T> metric;
+  int furthestIndex = argmax_metric(points, start + 1, end, s, e, metric);
+  if (furthestIndex == -1)
+    return std::make_tuple(-1, T{0});
+  return std::make_tuple(furthestIndex,
+                         static_cast<T>(metric_distance(s, e, metric)));
+}
+
+/**
+ * Same as furthest_point for points with _N_ coordinates. The distance of a
+ * point from the line is the length of what is left of it after removing
+ * its projection onto the line, with every sum over the coordinates
+ * unrolled at compile time. Degenerate segments give the distance from the
+ * start point, as in 2D.
+ *
+ * Points are measured in blocks whose distances are stored before the
+ * block is searched for its largest one. This keeps the comparison out of
+ * the loop doing the arithmetic so that the points of a block are measured
+ * independently of each other.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  requires(N != 2)
+[[nodiscard]] std::tuple<int, T> furthest_point(point<T, N> const *points,
+                                                int start, int end) {
+  using M = rdp_metric_t<T>;
+  constexpr int block = 64;
+
+  M s[N], d[N];
+  M len2 = 0;
+  unroll<N>([&](auto k) {
+    s[k] = M(points[start][k]);
+    d[k] = M(points[end][k]) - s[k];
+    len2 += d[k] * d[k];
+  });
+  M inverse = len2 == 0 ? 0 : 1 / len2;
+
+  auto metric = [&](point<T, N> const &p) {
+    M r[N];
+    M along = 0;
+    unroll<N>([&](auto k) {
+      r[k] = M(p[k]) - s[k];
+      along += r[k] * d[k];
+    });
+    M t = along * inverse;
+    M m = 0;
+    unroll<N>([&](auto k) {
+      M off = r[k] - t * d[k];
+      m += off * off;
+    });
+    return m;
+  };
+
+  int furthestIndex = -1;
+  M record = 0;
+  int i = start + 1;
+  for (; i + block <= end; i += block) {
+    M m[block];
+    for (int j = 0; j < block; j++)
+      m[j] = metric(points[i + j]);
+
+    M best = 0;
+    for (int j = 0; j < block; j++)
+      best = m[j] > best ? m[j] : best;
+    if (best > record) {
+      record = best;
+      for (int j = 0; j < block; j++) {
+        if (m[j] == best) {
+          furthestIndex = i + j;
+          break;
+        }
+      }
+    }
+  }
+  for (; i < end; i++) {
+    M m = metric(points[i]);
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+
+  if (furthestIndex == -1)
+    return std::make_tuple(-1, T{0});
+  return std::make_tuple(furthestIndex, static_cast<T>(std::sqrt(record)));
+}
+
+/**
+ * Same as furthest_point for points stored as separate x and y arrays
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::tuple<int, T> furthest_point_soa(T const *xs, T const *ys,
+                                                    int start, int end) {
+  point<T> s{xs[start], ys[start]};
+  point<T> e{xs[end], ys[end]};
+
+  rdp_metric_t<T> metric = 0;
+  int furthestIndex = -1;
+  if constexpr (std::is_same_v<T, double>) {
+    rdp_segment seg;
+    rdp_segment_init(&seg, s.x, s.y, e.x, e.y);
+    furthestIndex =
+        rdp_kernel_argmax_soa(xs, ys, start + 1, end, &seg, &metric);
+  } else if constexpr (std::is_same_v<T, float>) {
+    rdp_segment seg;
+    rdp_segment_init(&seg, s.x, s.y, e.x, e.y);
+    furthestIndex =
+        rdp_kernel_argmax_soa_f32(xs, ys, start + 1, end, &seg, &metric);
+  } else {
+    T dx = e.x - s.x;
+    T dy = e.y - s.y;
+    T len2 = dx * dx + dy * dy;
+    for (int i = start + 1; i < end; i++) {
+      T rx = xs[i] - s.x;
+      T ry = ys[i] - s.y;
+      T c = rx * dy - ry * dx;
+      T m = len2 == 0 ? rx * rx + ry * ry : c * c;
+      if (m > metric) {
+        furthestIndex = i;
+        metric = m;
+      }
+    }
+  }
+
+  if (furthestIndex == -1)
+    return std::make_tuple(-1, T{0});
+  return std::make_tuple(furthestIndex,
+                         static_cast<T>(metric_distance(s, e, metric)));
+}
+
+#endif
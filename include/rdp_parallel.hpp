@@ -0,0 +1,151 @@
+#ifndef RDP_PARALLEL_HPP
+#define RDP_PARALLEL_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_engine.hpp"
+#include "rdp_kernel.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Same as the serial furthest_point but when the range has at least
+ * _scanCutoff_ points it is split into chunks that are scanned in parallel
+ * on _executor_. The chunk results are reduced in index order keeping the
+ * first of equal maxima, and every chunk computes bit-identical metrics, so
+ * the result always matches the serial scan.
+ */
+template <FLOATING_POINT_CONCEPT T>
+[[nodiscard]] std::tuple<int, T>
+furthest_point(point<T> const *points, int start, int end,
+               thread_pool &executor,
+               int scanCutoff = rdp_default_scan_cutoff) {
+  // smaller chunks cost more to schedule than they save
+  constexpr int minChunk = 1 << 16;
+
+  int count = end - start - 1;
+  if (count < scanCutoff || count < 2 * minChunk || executor.size() < 2)
+    return furthest_point(points, start, end);
+
+  point<T> const &s = points[start];
+  point<T> const &e = points[end];
+
+  int chunks = std::min<int>(4 * executor.size(), count / minChunk);
+  int chunkSize = (count + chunks - 1) / chunks;
+
+  struct chunk_result {
+    int index = -1;
+    rdp_metric_t<T> metric = 0;
+  };
+  std::vector<chunk_result> results(chunks);
+
+  {
+    task_group group(executor);
+    for (int c = 0; c < chunks; c++) {
+      group.run([&, c] {
+        int first = start + 1 + c * chunkSize;
+        int last = std::min(first + chunkSize, end);
+        results[c].index =
+            argmax_metric(points, first, last, s, e, results[c].metric);
+      });
+    }
+    group.wait();
+  }
+
+  int furthestIndex = -1;
+  rdp_metric_t<T> record = 0;
+  for (auto const &r : results) {
+    if (r.index != -1 && r.metric > record) {
+      furthestIndex = r.index;
+      record = r.metric;
+    }
+  }
+  if (furthestIndex == -1)
+    return std::make_tuple(-1, T{0});
+  return std::make_tuple(furthestIndex,
+                         static_cast<T>(metric_distance(s, e, record)));
+}
+
+/**
+ * Simplifies the range between _start_ and _end_, marking kept points in
+ * _mask_. While the range is at least _cutoff_ points long the right half of
+ * each split is handed to _group_ and this task carries on with the left.
+ * Scans of at least _scanCutoff_ points are themselves split across threads.
+ */
+template <FLOATING_POINT_CONCEPT T>
+void rdp_parallel_range(point<T> const *points, int start, int end,
+                        double epsilon, int cutoff, int scanCutoff,
+                        unsigned char *mask, task_group &group,
+                        thread_pool &executor) {
+  while (end - start >= cutoff) {
+    auto [furthestIdx, d] =
+        furthest_point(points, start, end, executor, scanCutoff);
+    if (furthestIdx == -1 || d < epsilon)
+      return;
+
+    mask[furthestIdx] = 1;
+    group.run([=, &group, &executor] {
+      rdp_parallel_range(points, furthestIdx, end, epsilon, cutoff,
+                         scanCutoff, mask, group, executor);
+    });
+    end = furthestIdx;
+  }
+
+  // rdp_split never waits for other tasks, so a thread cannot start a second
+  // use of the stack before the first one has finished
+  thread_local std::vector<rdp_span> stack;
+  rdp_split(points, start, end, epsilon, stack,
+            [mask](int i) { mask[i] = 1; });
+}
+
+/**
+ * Same as the serial rdp_simplify but splits the work into tasks on
+ * _executor_. Every task marks the points it keeps in one shared mask, with
+ * each index written by exactly one task, and the mask is read in order
+ * afterwards, so the result is identical for any number of threads.
+ *
+ * Ranges shorter than _cutoff_ are simplified inline. Inputs shorter than it
+ * run entirely on the calling thread. Scans of at least _scanCutoff_ points,
+ * which are the first few splits of a large input, are divided between the
+ * threads as well.
+ */
+template <FLOATING_POINT_CONCEPT T>
+void rdp_simplify(point<T> const *points, int length, double epsilon,
+                  thread_pool &executor, rdp_workspace<T> &ws, int cutoff,
+                  int scanCutoff) {
+  if (cutoff < 2)
+    cutoff = 2;
+
+  if (length < cutoff) {
+    rdp_simplify(points, length, epsilon, ws);
+    return;
+  }
+
+  ws.mask_.assign(length, 0);
+  ws.mask_.front() = 1;
+  ws.mask_.back() = 1;
+
+  {
+    task_group group(executor);
+    unsigned char *mask = ws.mask_.data();
+    group.run([=, &group, &executor] {
+      rdp_parallel_range(points, 0, length - 1, epsilon, cutoff, scanCutoff,
+                         mask, group, executor);
+    });
+    group.wait();
+  }
+
+  ws.indices_.clear();
+  ws.points_.clear();
+  for (int i = 0; i < length; i++) {
+    if (ws.mask_[i]) {
+      ws.indices_.push_back(i);
+      ws.points_.push_back(points[i]);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef RDP_RESULT_HPP
+#define RDP_RESULT_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * One bit per point of a curve recording whether a simplification kept it.
+ * This is the smallest form a result can take, an eighth of a byte per input
+ * point, and is meant for inputs too large to hold a second copy of.
+ */
+class rdp_mask {
+  std::vector<std::uint64_t> words_;
+  std::size_t size_ = 0;
+
+public:
+  rdp_mask() = default;
+
+  /**
+   * A mask for _size_ points with none of them kept
+   */
+  explicit rdp_mask(std::size_t size) : words_((size + 63) / 64), size_(size) {}
+
+  void set(std::size_t i) noexcept { words_[i / 64] |= std::uint64_t{1} << (i % 64); }
+
+  [[nodiscard]] bool test(std::size_t i) const noexcept {
+    return (words_[i / 64] >> (i % 64)) & 1;
+  }
+
+  /**
+   * The number of points in the curve the mask was made for
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+  /**
+   * The number of kept points
+   */
+  [[nodiscard]] std::size_t count() const noexcept {
+    std::size_t total = 0;
+    for (auto w : words_)
+      total += static_cast<std::size_t>(__builtin_popcountll(w));
+    return total;
+  }
+
+  /**
+   * Calls f(i) for every kept index in ascending order
+   */
+  template <typename F> void for_each(F &&f) const {
+    for (std::size_t w = 0; w < words_.size(); w++) {
+      for (std::uint64_t bits = words_[w]; bits != 0; bits &= bits - 1)
+        f(w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits)));
+    }
+  }
+
+  [[nodiscard]] std::vector<std::uint64_t> const &words() const noexcept {
+    return words_;
+  }
+};
+
+/**
+ * The points a simplification kept, seen through the curve they came from.
+ * Only the indices are stored, four bytes per kept point, and points are
+ * read from the original curve on access, so the original must outlive the
+ * view and must not be modified while it is in use.
+ */
+template <FLOATING_POINT_CONCEPT T = double, std::size_t N = 2>
+class curve_view {
+  std::span<point<T, N> const> source_;
+  std::vector<int> indices_;
+
+public:
+  class iterator {
+    point<T, N> const *source_;
+    int const *index_;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = point<T, N>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = point<T, N> const *;
+    using reference = point<T, N> const &;
+
+    iterator() = default;
+
+    iterator(point<T, N> const *source, int const *index)
+        : source_(source), index_(index) {}
+
+    reference operator*() const { return source_[*index_]; }
+    pointer operator->() const { return &source_[*index_]; }
+    reference operator[](difference_type n) const { return source_[index_[n]]; }
+
+    iterator &operator++() { ++index_; return *this; }
+    iterator operator++(int) { auto copy = *this; ++index_; return copy; }
+    iterator &operator--() { --index_; return *this; }
+    iterator operator--(int) { auto copy = *this; --index_; return copy; }
+    iterator &operator+=(difference_type n) { index_ += n; return *this; }
+    iterator &operator-=(difference_type n) { index_ -= n; return *this; }
+    iterator operator+(difference_type n) const { return {source_, index_ + n}; }
+    iterator operator-(difference_type n) const { return {source_, index_ - n}; }
+    friend iterator operator+(difference_type n, iterator it) { return it + n; }
+    difference_type operator-(iterator const &other) const { return index_ - other.index_; }
+
+    bool operator==(iterator const &other) const { return index_ == other.index_; }
+    auto operator<=>(iterator const &other) const { return index_ <=> other.index_; }
+  };
+
+  curve_view() = default;
+
+  curve_view(std::span<point<T, N> const> source, std::vector<int> indices)
+      : source_(source), indices_(std::move(indices)) {}
+
+  [[nodiscard]] std::size_t size() const noexcept { return indices_.size(); }
+
+  [[nodiscard]] point<T, N> const &operator[](std::size_t k) const {
+    return source_[indices_[k]];
+  }
+
+  [[nodiscard]] iterator begin() const {
+    return {source_.data(), indices_.data()};
+  }
+
+  [[nodiscard]] iterator end() const {
+    return {source_.data(), indices_.data() + indices_.size()};
+  }
+
+  /**
+   * Indices into the original curve of the kept points in ascending order
+   */
+  [[nodiscard]] std::vector<int> const &indices() const noexcept {
+    return indices_;
+  }
+
+  /**
+   * All the points of the original curve
+   */
+  [[nodiscard]] std::span<point<T, N> const> source() const noexcept {
+    return source_;
+  }
+
+  /**
+   * Copies the kept points. This is the only operation on a view that does.
+   */
+  [[nodiscard]] std::vector<point<T, N>> copy_points() const {
+    return std::vector<point<T, N>>(begin(), end());
+  }
+};
+
+#endif
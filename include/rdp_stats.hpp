@@ -0,0 +1,168 @@
+#ifndef RDP_STATS_HPP
+#define RDP_STATS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/**
+ * What happened during one simplification. Filled in by passing an
+ * rdp_stats_collector as the stats policy of the engine, for example through
+ * curve::rdp(double, rdp_stats &).
+ */
+struct rdp_stats {
+  // points whose distance from a segment was measured
+  std::uint64_t distanceEvaluations = 0;
+  // ranges that were scanned for their furthest point
+  std::uint64_t segments = 0;
+  std::uint64_t kept = 0;
+  // the most ranges pending at once, which is what a recursive
+  // implementation would have as its recursion depth
+  std::size_t maxDepth = 0;
+  // growth of the workspace buffers
+  std::size_t bytesAllocated = 0;
+  // finding the points to keep
+  std::chrono::nanoseconds splitTime{0};
+  // copying the kept points out
+  std::chrono::nanoseconds gatherTime{0};
+};
+
+enum class rdp_phase { split, gather };
+
+/**
+ * Collects trace events in the Chrome trace event format, which
+ * chrome://tracing, Perfetto and speedscope can display. Every phase of a
+ * simplification is recorded as is every scan of at least _minSegment_
+ * points, so only the scans that matter show up in long runs.
+ */
+class rdp_trace {
+public:
+  using clock = std::chrono::steady_clock;
+
+  explicit rdp_trace(int minSegment = 1 << 12)
+      : minSegment_(minSegment), origin_(clock::now()) {}
+
+  [[nodiscard]] int min_segment() const noexcept { return minSegment_; }
+
+  /**
+   * Records an event called _name_ that ran from _start_ to _end_ over the
+   * range of points from _first_ to _last_, or -1 if it is not about a range
+   */
+  void complete(char const *name, clock::time_point start,
+                clock::time_point end, int first = -1, int last = -1) {
+    events_.push_back({name, start, end, first, last});
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return events_.size(); }
+
+  void clear() noexcept { events_.clear(); }
+
+  /**
+   * Writes the events as a JSON object with a traceEvents array
+   */
+  void write(std::ostream &out) const {
+    using us = std::chrono::duration<double, std::micro>;
+    out << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events_.size(); i++) {
+      auto const &e = events_[i];
+      out << (i == 0 ? "" : ",") << "\n{\"name\":\"" << e.name
+          << "\",\"cat\":\"rdp\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+          << us(e.start - origin_).count()
+          << ",\"dur\":" << us(e.end - e.start).count();
+      if (e.first != -1)
+        out << ",\"args\":{\"start\":" << e.first << ",\"end\":" << e.last
+            << ",\"points\":" << e.last - e.first - 1 << "}";
+      out << "}";
+    }
+    out << "\n]}\n";
+  }
+
+private:
+  struct event {
+    char const *name;
+    clock::time_point start, end;
+    int first, last;
+  };
+
+  int minSegment_;
+  clock::time_point origin_;
+  std::vector<event> events_;
+};
+
+/**
+ * The stats policy the engine uses by default. Every hook does nothing and
+ * is inlined away, so simplifying without stats costs exactly what it did
+ * before the hooks existed.
+ */
+struct rdp_no_stats {
+  template <typename Scan> decltype(auto) scan(int, int, Scan &&scan) {
+    return scan();
+  }
+
+  void depth(std::size_t) noexcept {}
+
+  template <typename Body> void phase(rdp_phase, Body &&body) { body(); }
+
+  void allocated(std::size_t) noexcept {}
+
+  void kept(std::size_t) noexcept {}
+};
+
+/**
+ * The stats policy that fills in an rdp_stats and, if given one, records
+ * trace events. The counters are not atomic, so a collector must only be
+ * used by one simplification at a time.
+ */
+class rdp_stats_collector {
+public:
+  explicit rdp_stats_collector(rdp_stats &stats, rdp_trace *trace = nullptr)
+      : stats_(stats), trace_(trace) {}
+
+  /**
+   * Runs the furthest point scan of the range from _start_ to _end_
+   */
+  template <typename Scan> decltype(auto) scan(int start, int end, Scan &&scan) {
+    stats_.segments++;
+    stats_.distanceEvaluations += static_cast<std::uint64_t>(
+        std::max(end - start - 1, 0));
+    if (trace_ == nullptr || end - start - 1 < trace_->min_segment())
+      return scan();
+
+    auto begin = rdp_trace::clock::now();
+    auto result = scan();
+    trace_->complete("scan", begin, rdp_trace::clock::now(), start, end);
+    return result;
+  }
+
+  /**
+   * Called with the number of pending ranges whenever it grows
+   */
+  void depth(std::size_t pending) noexcept {
+    stats_.maxDepth = std::max(stats_.maxDepth, pending);
+  }
+
+  template <typename Body> void phase(rdp_phase which, Body &&body) {
+    auto begin = rdp_trace::clock::now();
+    body();
+    auto end = rdp_trace::clock::now();
+
+    bool split = which == rdp_phase::split;
+    (split ? stats_.splitTime : stats_.gatherTime) += end - begin;
+    if (trace_ != nullptr)
+      trace_->complete(split ? "split" : "gather", begin, end);
+  }
+
+  void allocated(std::size_t bytes) noexcept { stats_.bytesAllocated += bytes; }
+
+  void kept(std::size_t count) noexcept { stats_.kept += count; }
+
+private:
+  rdp_stats &stats_;
+  rdp_trace *trace_;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef SIMPLIFIER_HPP
+#define SIMPLIFIER_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "prefilter.hpp"
+#include "rdp_engine.hpp"
+#include "rdp_kernel.hpp"
+#include "simplify_kernel.hpp"
+#include "visvalingam.hpp"
+#include <concepts>
+#include <cstddef>
+#include <vector>
+
+/**
+ * A simplification algorithm together with its parameter, which is what
+ * curve::simplify takes so the algorithms can be swapped and compared on
+ * the same inputs. s.simplify(points, length, kept) stores the indices of
+ * the points it keeps in _kept_ in ascending order.
+ */
+template <typename S, typename T, std::size_t N>
+concept curve_simplifier =
+    requires(S const &s, point<T, N> const *points, int length,
+             std::vector<int> &kept) {
+      { S::name } -> std::convertible_to<char const *>;
+      s.simplify(points, length, kept);
+    };
+
+/**
+ * Ramer-Douglas-Peuker keeping every point at least _epsilon_ from the
+ * simplified curve, the same as curve::rdp
+ */
+struct rdp_simplifier {
+  static constexpr char const *name = "rdp";
+  double epsilon;
+
+  template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  void simplify(point<T, N> const *points, int length,
+                std::vector<int> &kept) const {
+    rdp_workspace<T, N> ws;
+    rdp_simplify_indices(points, length, epsilon, ws);
+    kept = ws.take_indices();
+  }
+};
+
+/**
+ * Ramer-Douglas-Peuker refined to _count_ points, the same as
+ * curve::rdp_to_count
+ */
+struct rdp_count_simplifier {
+  static constexpr char const *name = "rdp_to_count";
+  int count;
+
+  template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  void simplify(point<T, N> const *points, int length,
+                std::vector<int> &kept) const {
+    rdp_refine_by(
+        length - 1, count,
+        [points](int s, int e) { return furthest_point(points, s, e); }, kept);
+  }
+};
+
+/**
+ * Visvalingam-Whyatt removing every point whose triangle is smaller than
+ * _area_, the same as curve::visvalingam
+ */
+struct visvalingam_simplifier {
+  static constexpr char const *name = "visvalingam";
+  double area;
+
+  template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  void simplify(point<T, N> const *points, int length,
+                std::vector<int> &kept) const {
+    simplify_buffers ws;
+    visvalingam_simplify(points, length, area, length, ws);
+    kept.assign(ws.indices().begin(), ws.indices().end());
+  }
+};
+
+/**
+ * Visvalingam-Whyatt down to _count_ points, the same as
+ * curve::visvalingam_to_count
+ */
+struct visvalingam_count_simplifier {
+  static constexpr char const *name = "visvalingam_to_count";
+  int count;
+
+  template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  void simplify(point<T, N> const *points, int length,
+                std::vector<int> &kept) const {
+    simplify_buffers ws;
+    visvalingam_simplify(points, length, 0, count, ws);
+    kept.assign(ws.indices().begin(), ws.indices().end());
+  }
+};
+
+/**
+ * Radial distance filter dropping points closer than _tolerance_ to the
+ * last kept point, the same as curve::radial_distance
+ */
+struct radial_distance_simplifier {
+  static constexpr char const *name = "radial_distance";
+  double tolerance;
+
+  template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  void simplify(point<T, N> const *points, int length,
+                std::vector<int> &kept) const {
+    simplify_buffers ws;
+    radial_distance_simplify(points, length, tolerance, ws);
+    kept.assign(ws.indices().begin(), ws.indices().end());
+  }
+};
+
+/**
+ * Reumann-Witkam filter with a strip _tolerance_ wide, the same as
+ * curve::reumann_witkam
+ */
+struct reumann_witkam_simplifier {
+  static constexpr char const *name = "reumann_witkam";
+  double tolerance;
+
+  template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  void simplify(point<T, N> const *points, int length,
+                std::vector<int> &kept) const {
+    simplify_buffers ws;
+    reumann_witkam_simplify(points, length, tolerance, ws);
+    kept.assign(ws.indices().begin(), ws.indices().end());
+  }
+};
+
+/**
+ * Runs _simplifier_ on the points _prefilter_ keeps, usually one of the
+ * filters from prefilter.hpp in front of rdp. With a prefilter tolerance of
+ * t and rdp at epsilon every dropped point is within t + epsilon of the
+ * line through its kept neighbours. The kept indices refer to the original
+ * points.
+ */
+template <typename Prefilter, typename Simplifier>
+struct prefiltered_simplifier {
+  static constexpr char const *name = "prefiltered";
+  Prefilter prefilter;
+  Simplifier simplifier;
+
+  template <FLOATING_POINT_CONCEPT T, std::size_t N>
+  void simplify(point<T, N> const *points, int length,
+                std::vector<int> &kept) const {
+    std::vector<int> candidates;
+    prefilter.simplify(points, length, candidates);
+
+    std::vector<point<T, N>> reduced;
+    reduced.reserve(candidates.size());
+    for (int i : candidates)
+      reduced.push_back(points[i]);
+
+    simplifier.simplify(reduced.data(), static_cast<int>(reduced.size()),
+                        kept);
+    for (int &k : kept)
+      k = candidates[k];
+  }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef SIMPLIFY_KERNEL_H
+#define SIMPLIFY_KERNEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The simplification algorithms other than rdp, shared by the C and C++
+ * implementations. They read _length_ points of _dimension_ interleaved
+ * coordinates each from _coords_, and the _f32 versions read float
+ * coordinates but compute in double, like the rdp kernels.
+ */
+
+/**
+ * An interior point in the Visvalingam-Whyatt heap. The area is stored next
+ * to the index so the heap can be reordered without looking anything up.
+ */
+struct simplify_heap_entry {
+  double area;
+  int index;
+};
+
+/**
+ * Buffers used by the simplify kernels between calls. Reusing a workspace
+ * means nothing is allocated once the buffers have grown to fit the largest
+ * input. After each call _indices_ holds the _length_ kept points in
+ * ascending order.
+ *
+ * The points still in the curve form a doubly linked list through the
+ * first two thirds of _links_, and the last third is where each interior
+ * point is in _heap_, a binary min-heap of their areas.
+ *
+ * Initialize with simplify_workspace_init and release with
+ * simplify_workspace_free
+ */
+struct simplify_workspace {
+  int *indices;
+  int length;
+  int indices_capacity;
+  int *links;
+  struct simplify_heap_entry *heap;
+  int heap_capacity;
+};
+
+void simplify_workspace_init(struct simplify_workspace *ws);
+void simplify_workspace_free(struct simplify_workspace *ws);
+
+/**
+ * Keeps the first and last points and every point at least _tolerance_
+ * from the point kept before it, so every dropped point is within
+ * _tolerance_ of a kept point.
+ */
+void simplify_kernel_radial_distance(double const *coords, int dimension,
+                                     int length, double tolerance,
+                                     struct simplify_workspace *ws);
+void simplify_kernel_radial_distance_f32(float const *coords, int dimension,
+                                         int length, double tolerance,
+                                         struct simplify_workspace *ws);
+
+/**
+ * Keeps the points where the curve leaves a strip _tolerance_ wide around
+ * the line from the last point kept through the next point that differs
+ * from it, the Reumann-Witkam algorithm. The point before the one that
+ * leaves is kept and a new strip starts there. A point also leaves when it
+ * goes back along the line, so every dropped point is less than
+ * _tolerance_ from the segment between the kept ends of its run.
+ */
+void simplify_kernel_reumann_witkam(double const *coords, int dimension,
+                                    int length, double tolerance,
+                                    struct simplify_workspace *ws);
+void simplify_kernel_reumann_witkam_f32(float const *coords, int dimension,
+                                        int length, double tolerance,
+                                        struct simplify_workspace *ws);
+
+/**
+ * Removes the interior point making the smallest triangle with its
+ * neighbours, the lowest index on ties, until that area is at least _area_
+ * and no more than _count_ points are left. Pass 0 for _area_ to only stop
+ * at a count, or _length_ for _count_ to only stop at an area. A point's
+ * area is never allowed below that of a point removed before it, so the
+ * removal order is the same for every threshold.
+ *
+ * returns: the largest area of a removed point, or 0 if none was removed
+ */
+double simplify_kernel_visvalingam(double const *coords, int dimension,
+                                   int length, double area, int count,
+                                   struct simplify_workspace *ws);
+double simplify_kernel_visvalingam_f32(float const *coords, int dimension,
+                                       int length, double area, int count,
+                                       struct simplify_workspace *ws);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
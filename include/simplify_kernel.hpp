@@ -0,0 +1,70 @@
+#ifndef SIMPLIFY_KERNEL_HPP
+#define SIMPLIFY_KERNEL_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "simplify_kernel.h"
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Owns the buffers of a simplify_workspace from simplify_kernel.h so they
+ * are released with it. Reusing one for repeated simplifications means
+ * nothing is allocated once the buffers have grown to fit the largest
+ * input.
+ */
+class simplify_buffers {
+public:
+  simplify_buffers() noexcept { simplify_workspace_init(&ws_); }
+
+  ~simplify_buffers() { simplify_workspace_free(&ws_); }
+
+  simplify_buffers(simplify_buffers const &) = delete;
+  simplify_buffers &operator=(simplify_buffers const &) = delete;
+
+  simplify_buffers(simplify_buffers &&other) noexcept : ws_(other.ws_) {
+    simplify_workspace_init(&other.ws_);
+  }
+
+  simplify_buffers &operator=(simplify_buffers &&other) noexcept {
+    std::swap(ws_, other.ws_);
+    return *this;
+  }
+
+  /**
+   * Indices into the input of the points kept by the last simplification in
+   * ascending order
+   */
+  [[nodiscard]] std::span<int const> indices() const noexcept {
+    return {ws_.indices, static_cast<std::size_t>(ws_.length)};
+  }
+
+  [[nodiscard]] simplify_workspace *get() noexcept { return &ws_; }
+
+private:
+  simplify_workspace ws_;
+};
+
+/**
+ * Calls the double or float version of a simplify kernel on the coordinates
+ * of _points_, which are laid out as the interleaved arrays they expect.
+ * Other coordinate types are not supported.
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N, typename F64, typename F32>
+decltype(auto) simplify_kernel_call(point<T, N> const *points, F64 &&f64,
+                                    F32 &&f32) {
+  static_assert(sizeof(point<T, N>) == N * sizeof(T),
+                "the kernels read points as interleaved coordinates");
+  if constexpr (std::is_same_v<T, double>) {
+    return f64(reinterpret_cast<double const *>(points), static_cast<int>(N));
+  } else {
+    static_assert(std::is_same_v<T, float>,
+                  "the simplify kernels only read float and double points");
+    return f32(reinterpret_cast<float const *>(points), static_cast<int>(N));
+  }
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef STREAMING_SIMPLIFIER_HPP
+#define STREAMING_SIMPLIFIER_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "rdp_engine.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Simplifies a stream of points with the Ramer-Douglas-Peuker algorithm
+ * without ever holding more than _window_ of them.
+ *
+ * Points are added in x order, the same way as with curve::addPoint. Each
+ * time the window fills up it is simplified and the points kept in its first
+ * part are emitted, since nothing added later can change them. The last kept
+ * point becomes the start of the next window. If that would leave more than
+ * half the window pending, the end of the window is emitted too so every
+ * window shrinks to at most half its size. Memory and the work per point are
+ * therefore bounded by the window no matter how long the stream runs.
+ *
+ * Every input point is within epsilon of the emitted polyline, as with
+ * curve::rdp, but the output can contain a few more points than simplifying
+ * the whole curve at once because windows are cut independently. Once the
+ * window holds the whole input the result is identical to curve::rdp.
+ */
+template <FLOATING_POINT_CONCEPT T = double> class streaming_simplifier {
+public:
+  using callback = std::function<void(point<T> const &)>;
+
+  /**
+   * Calls _emit_ with every point that is kept, in order
+   */
+  streaming_simplifier(double epsilon, std::size_t window, callback emit)
+      : epsilon_(epsilon), window_(std::max<std::size_t>(window, 3)),
+        emit_(std::move(emit)) {
+    buffer_.reserve(window_);
+    ws_.reserve(window_);
+  }
+
+  /**
+   * Writes every point that is kept to _out_, in order
+   */
+  template <typename OutputIt>
+    requires std::output_iterator<OutputIt, point<T>>
+  streaming_simplifier(double epsilon, std::size_t window, OutputIt out)
+      : streaming_simplifier(epsilon, window, [out](point<T> const &p) mutable {
+          *out++ = p;
+        }) {}
+
+  /**
+   * Add the next point of the stream. Its x coordinate should not be smaller
+   * than that of the previous point.
+   */
+  void addPoint(point<T> const &p) {
+    if (buffer_.empty())
+      emit_(p);
+
+    buffer_.push_back(p);
+    if (buffer_.size() == window_)
+      flush_window();
+  }
+
+  /**
+   * Add the next point of the stream. Its x coordinate should not be smaller
+   * than that of the previous point.
+   */
+  void addPoint(T x, T y) { addPoint(point<T>{x, y}); }
+
+  /**
+   * Add the points in [first, last) in order
+   */
+  template <typename It> void addPoints(It first, It last) {
+    for (; first != last; ++first)
+      addPoint(*first);
+  }
+
+  /**
+   * Ends the stream, emitting whatever is still pending including the last
+   * point. Points added afterwards start a new stream.
+   */
+  void finish() {
+    if (buffer_.size() > 1) {
+      rdp_simplify_indices(buffer_.data(), static_cast<int>(buffer_.size()),
+                           epsilon_, ws_);
+      auto const &kept = ws_.indices();
+      for (std::size_t k = 1; k < kept.size(); k++)
+        emit_(buffer_[kept[k]]);
+    }
+    buffer_.clear();
+  }
+
+  /**
+   * The number of points held back waiting for more input, including the
+   * already emitted point the next window starts from
+   */
+  [[nodiscard]] std::size_t pending() const noexcept { return buffer_.size(); }
+
+  [[nodiscard]] std::size_t window() const noexcept { return window_; }
+
+private:
+  double epsilon_;
+  std::size_t window_;
+  callback emit_;
+  std::vector<point<T>> buffer_;
+  rdp_workspace<T> ws_;
+
+  void flush_window() {
+    int length = static_cast<int>(buffer_.size());
+    rdp_simplify_indices(buffer_.data(), length, epsilon_, ws_);
+    auto const &kept = ws_.indices();
+
+    // everything before the last kept interior point is final
+    int anchor = kept[kept.size() - 2];
+    for (std::size_t k = 1; k + 1 < kept.size(); k++)
+      emit_(buffer_[kept[k]]);
+
+    if (length - anchor > static_cast<int>(window_ / 2)) {
+      anchor = length - 1;
+      emit_(buffer_[anchor]);
+    }
+
+    buffer_.erase(buffer_.begin(), buffer_.begin() + anchor);
+  }
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed size pool of worker threads that share work by stealing.
+ *
+ * Every worker owns a deque of tasks. Tasks submitted from a worker go on the
+ * back of its own deque and it takes work from the back as well, so related
+ * tasks stay on the same core. Idle workers steal from the front of the other
+ * deques, which holds the oldest and usually largest tasks. Tasks submitted
+ * from outside the pool are spread over the workers in turn.
+ */
+class thread_pool {
+
+  struct worker_queue {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<worker_queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<unsigned> next_queue_{0};
+  std::atomic<int> queued_{0};
+  std::mutex sleep_lock_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+
+  void worker_loop(unsigned index);
+
+  bool pop_task(unsigned index, std::function<void()> &task);
+
+  bool steal_task(unsigned thief, std::function<void()> &task);
+
+public:
+  /**
+   * Starts _threads_ workers. Passing 0 uses one worker per hardware thread.
+   */
+  explicit thread_pool(unsigned threads = 0);
+
+  ~thread_pool();
+
+  thread_pool(thread_pool const &) = delete;
+
+  thread_pool &operator=(thread_pool const &) = delete;
+
+  [[nodiscard]] unsigned size() const noexcept {
+    return static_cast<unsigned>(workers_.size());
+  }
+
+  /**
+   * Queues _task_ to run on one of the workers
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * Runs one queued task on the calling thread if there is any. Threads that
+   * wait for tasks call this so they help instead of blocking, which also
+   * means waiting inside a task cannot deadlock the pool.
+   *
+   * returns: true if a task was run
+   */
+  bool run_pending();
+};
+
+/**
+ * Tracks a set of tasks submitted to a thread_pool so they can be waited on
+ * together. Tasks may add more tasks to the group they belong to.
+ */
+class task_group {
+  thread_pool &pool_;
+  std::atomic<long> pending_{0};
+
+public:
+  explicit task_group(thread_pool &pool) : pool_(pool) {}
+
+  task_group(task_group const &) = delete;
+
+  task_group &operator=(task_group const &) = delete;
+
+  ~task_group() { wait(); }
+
+  /**
+   * Submits _f_ to the pool as part of this group
+   */
+  template <typename F> void run(F &&f) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.submit([this, f = std::forward<F>(f)]() mutable {
+      f();
+      pending_.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  /**
+   * Returns once every task run in this group, including the tasks those
+   * tasks added, has finished. The calling thread runs queued tasks while it
+   * waits.
+   */
+  void wait() {
+    while (pending_.load(std::memory_order_acquire) != 0) {
+      if (!pool_.run_pending())
+        std::this_thread::yield();
+    }
+  }
+};
+
+#endif
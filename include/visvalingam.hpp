@@ -0,0 +1,39 @@
+#ifndef VISVALINGAM_HPP
+#define VISVALINGAM_HPP
+
+#include "legacysupport.hpp"
+#include "point.hpp"
+#include "simplify_kernel.hpp"
+#include <cstddef>
+
+/**
+ * Simplifies the _length_ points starting at _points_ with the
+ * Visvalingam-Whyatt algorithm and stores the kept indices in ascending
+ * order in _ws_. The interior point making the smallest triangle with its
+ * neighbours is removed again and again until that area is at least
+ * _area_ and no more than _count_ points are left. Pass 0 for _area_ to
+ * only stop at a count, or _length_ for _count_ to only stop at an area.
+ *
+ * This runs simplify_kernel_visvalingam, which the C implementation shares.
+ * The points still in the curve are a doubly linked list and the interior
+ * ones sit in an indexed binary min-heap of their areas, and the buffers in
+ * _ws_ are sized once per call, so removing a point never allocates.
+ *
+ * returns: the largest area of a removed point, or 0 if none was removed
+ */
+template <FLOATING_POINT_CONCEPT T, std::size_t N>
+double visvalingam_simplify(point<T, N> const *points, int length,
+                            double area, int count, simplify_buffers &ws) {
+  return simplify_kernel_call(
+      points,
+      [&](double const *coords, int dimension) {
+        return simplify_kernel_visvalingam(coords, dimension, length, area,
+                                           count, ws.get());
+      },
+      [&](float const *coords, int dimension) {
+        return simplify_kernel_visvalingam_f32(coords, dimension, length,
+                                               area, count, ws.get());
+      });
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "curve_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(struct curve_file_header) == 64,
+               "the header must keep the coordinates vector aligned");
+
+size_t curve_file_type_size(enum curve_file_type type) {
+  switch (type) {
+  case CURVE_FILE_FLOAT32:
+    return sizeof(float);
+  case CURVE_FILE_FLOAT64:
+    return sizeof(double);
+  }
+  return 0;
+}
+
+bool curve_file_write(char const *path, enum curve_file_type type,
+                      int dimension, enum curve_file_layout layout,
+                      uint64_t count, void const *const *coords) {
+  size_t element = curve_file_type_size(type);
+  if (element == 0 || dimension < 1 || dimension > UINT8_MAX ||
+      (layout != CURVE_FILE_INTERLEAVED && layout != CURVE_FILE_SEPARATE)) {
+    errno = EINVAL;
+    return false;
+  }
+
+  struct curve_file_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CURVE_FILE_MAGIC, sizeof(header.magic));
+  header.version = CURVE_FILE_VERSION;
+  header.header_size = sizeof(header);
+  header.byte_order = CURVE_FILE_BYTE_ORDER;
+  header.type = (uint8_t)type;
+  header.dimension = (uint8_t)dimension;
+  header.layout = (uint8_t)layout;
+  header.count = count;
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+    return false;
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  if (layout == CURVE_FILE_INTERLEAVED) {
+    ok = ok && fwrite(coords[0], element * dimension, count, file) == count;
+  } else {
+    for (int d = 0; ok && d < dimension; d++)
+      ok = fwrite(coords[d], element, count, file) == count;
+  }
+
+  if (fclose(file) != 0)
+    ok = false;
+  return ok;
+}
+
+/*
+ * Checks that the header describes a file this version can read and that
+ * the coordinates it announces fit in the _size_ bytes that were mapped
+ */
+static bool header_valid(struct curve_file_header const *header, size_t size) {
+  if (size < sizeof(*header))
+    return false;
+  if (memcmp(header->magic, CURVE_FILE_MAGIC, sizeof(header->magic)) != 0)
+    return false;
+  if (header->version == 0 || header->version > CURVE_FILE_VERSION)
+    return false;
+  if (header->byte_order != CURVE_FILE_BYTE_ORDER)
+    return false;
+
+  size_t element = curve_file_type_size(header->type);
+  if (element == 0 || header->dimension == 0)
+    return false;
+  // the coordinates are read in place, so they must be aligned to their size
+  if (header->header_size < sizeof(*header) || header->header_size > size ||
+      header->header_size % element != 0)
+    return false;
+  if (header->layout != CURVE_FILE_INTERLEAVED &&
+      header->layout != CURVE_FILE_SEPARATE)
+    return false;
+
+  size_t available = (size - header->header_size) / element;
+  return header->count <= available / header->dimension;
+}
+
+bool curve_file_open(char const *path, struct curve_file_map *map) {
+
+#ifdef DEBUG
+  if (map == NULL) {
+    fprintf(stderr, "Do not pass null to curve_file_open()\n");
+    abort();
+  }
+#endif
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) == -1) {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return false;
+  }
+
+  size_t size = (size_t)info.st_size;
+  if (size < sizeof(struct curve_file_header)) {
+    close(fd);
+    errno = EINVAL;
+    return false;
+  }
+
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  int saved = errno;
+  close(fd);
+  if (base == MAP_FAILED) {
+    errno = saved;
+    return false;
+  }
+
+  struct curve_file_header const *header = base;
+  if (!header_valid(header, size)) {
+    munmap(base, size);
+    errno = EINVAL;
+    return false;
+  }
+
+  map->base = base;
+  map->size = size;
+  map->header = header;
+  map->data = (char *)base + header->header_size;
+  return true;
+}
+
+void curve_file_close(struct curve_file_map *map) {
+  if (map->base != NULL)
+    munmap(map->base, map->size);
+  map->base = NULL;
+  map->size = 0;
+  map->header = NULL;
+  map->data = NULL;
+}
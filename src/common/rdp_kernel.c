@@ -0,0 +1,1089 @@
+#include "rdp_kernel.h"
+#include <math.h>
+#include <stddef.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define RDP_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Every implementation evaluates the metric with exactly the same operations
+ * in the same order, (px - sx) * dy - (py - sy) * dx squared, so all of them
+ * produce bit-identical metrics and therefore the same index. This file must
+ * be compiled with -ffp-contract=off to keep the compiler from fusing them.
+ */
+
+typedef int (*argmax_fn)(double const *xy, int first, int last,
+                         struct rdp_segment const *seg, double *metric);
+
+typedef int (*argmax_soa_fn)(double const *xs, double const *ys, int first,
+                             int last, struct rdp_segment const *seg,
+                             double *metric);
+
+typedef void (*minmax_fn)(double const *values, int length, double *min,
+                          double *max);
+
+typedef int (*argmax_f32_fn)(float const *xy, int first, int last,
+                             struct rdp_segment const *seg, double *metric);
+
+typedef int (*argmax_soa_f32_fn)(float const *xs, float const *ys, int first,
+                                 int last, struct rdp_segment const *seg,
+                                 double *metric);
+
+typedef void (*minmax_f32_fn)(float const *values, int length, float *min,
+                              float *max);
+
+void rdp_segment_init(struct rdp_segment *seg, double sx, double sy, double ex,
+                      double ey) {
+  seg->sx = sx;
+  seg->sy = sy;
+  seg->dx = ex - sx;
+  seg->dy = ey - sy;
+  seg->len2 = seg->dx * seg->dx + seg->dy * seg->dy;
+}
+
+double rdp_segment_distance(struct rdp_segment const *seg, double metric) {
+  if (seg->len2 == 0)
+    return sqrt(metric);
+  return sqrt(metric / seg->len2);
+}
+
+static int argmax_scalar(double const *xy, int first, int last,
+                         struct rdp_segment const *seg, double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double c = (xy[2 * i] - seg->sx) * seg->dy - (xy[2 * i + 1] - seg->sy) * seg->dx;
+    double m = c * c;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+/*
+ * Used for every ISA when the segment is a single point. This only happens
+ * for curves with repeated points so it is not worth vectorizing.
+ */
+static int argmax_degenerate(double const *xy, int first, int last,
+                             struct rdp_segment const *seg, double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double rx = xy[2 * i] - seg->sx;
+    double ry = xy[2 * i + 1] - seg->sy;
+    double m = rx * rx + ry * ry;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+static int argmax_soa_scalar(double const *xs, double const *ys, int first,
+                             int last, struct rdp_segment const *seg,
+                             double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double c = (xs[i] - seg->sx) * seg->dy - (ys[i] - seg->sy) * seg->dx;
+    double m = c * c;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+static int argmax_soa_degenerate(double const *xs, double const *ys,
+                                 int first, int last,
+                                 struct rdp_segment const *seg,
+                                 double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double rx = xs[i] - seg->sx;
+    double ry = ys[i] - seg->sy;
+    double m = rx * rx + ry * ry;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+static void minmax_scalar(double const *values, int length, double *min,
+                          double *max) {
+  double lo = values[0];
+  double hi = values[0];
+  for (int i = 1; i < length; i++) {
+    if (values[i] < lo)
+      lo = values[i];
+    if (values[i] > hi)
+      hi = values[i];
+  }
+  *min = lo;
+  *max = hi;
+}
+
+/*
+ * The float kernels widen every coordinate to double as it is loaded, which
+ * is exact, and then do the same operations as the double kernels. Their
+ * metrics are therefore bit-identical to running the double kernels on the
+ * widened coordinates while reading half as many bytes.
+ */
+
+static int argmax_f32_scalar(float const *xy, int first, int last,
+                             struct rdp_segment const *seg, double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double c = ((double)xy[2 * i] - seg->sx) * seg->dy -
+               ((double)xy[2 * i + 1] - seg->sy) * seg->dx;
+    double m = c * c;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+static int argmax_f32_degenerate(float const *xy, int first, int last,
+                                 struct rdp_segment const *seg,
+                                 double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double rx = (double)xy[2 * i] - seg->sx;
+    double ry = (double)xy[2 * i + 1] - seg->sy;
+    double m = rx * rx + ry * ry;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+static int argmax_soa_f32_scalar(float const *xs, float const *ys, int first,
+                                 int last, struct rdp_segment const *seg,
+                                 double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double c = ((double)xs[i] - seg->sx) * seg->dy -
+               ((double)ys[i] - seg->sy) * seg->dx;
+    double m = c * c;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+static int argmax_soa_f32_degenerate(float const *xs, float const *ys,
+                                     int first, int last,
+                                     struct rdp_segment const *seg,
+                                     double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int i = first; i < last; i++) {
+    double rx = (double)xs[i] - seg->sx;
+    double ry = (double)ys[i] - seg->sy;
+    double m = rx * rx + ry * ry;
+    if (m > record) {
+      furthestIndex = i;
+      record = m;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+static void minmax_f32_scalar(float const *values, int length, float *min,
+                              float *max) {
+  float lo = values[0];
+  float hi = values[0];
+  for (int i = 1; i < length; i++) {
+    if (values[i] < lo)
+      lo = values[i];
+    if (values[i] > hi)
+      hi = values[i];
+  }
+  *min = lo;
+  *max = hi;
+}
+
+/*
+ * Combines per-lane maxima with the result of the scalar scan of the tail.
+ * Lanes always hold lower indices than the tail so only lanes need the
+ * lowest-index tie break.
+ */
+static int reduce_lanes(double const *best, double const *index, int lanes,
+                        int tailIndex, double tailMetric, double *metric) {
+  int furthestIndex = -1;
+  double record = 0;
+  for (int j = 0; j < lanes; j++) {
+    if (index[j] < 0)
+      continue;
+    if (best[j] > record ||
+        (best[j] == record && (int)index[j] < furthestIndex)) {
+      furthestIndex = (int)index[j];
+      record = best[j];
+    }
+  }
+  if (tailIndex != -1 && tailMetric > record) {
+    furthestIndex = tailIndex;
+    record = tailMetric;
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+  return furthestIndex;
+}
+
+#ifdef RDP_KERNEL_X86
+
+__attribute__((target("sse2"))) static int
+argmax_sse2(double const *xy, int first, int last,
+            struct rdp_segment const *seg, double *metric) {
+  __m128d sx = _mm_set1_pd(seg->sx), sy = _mm_set1_pd(seg->sy);
+  __m128d dx = _mm_set1_pd(seg->dx), dy = _mm_set1_pd(seg->dy);
+  __m128d best = _mm_setzero_pd();
+  __m128d bestIndex = _mm_set1_pd(-1);
+  __m128d index = _mm_set_pd(first + 1, first);
+  __m128d step = _mm_set1_pd(2);
+
+  int i = first;
+  for (; i + 2 <= last; i += 2) {
+    __m128d a = _mm_loadu_pd(xy + 2 * i);
+    __m128d b = _mm_loadu_pd(xy + 2 * i + 2);
+    __m128d rx = _mm_sub_pd(_mm_unpacklo_pd(a, b), sx);
+    __m128d ry = _mm_sub_pd(_mm_unpackhi_pd(a, b), sy);
+    __m128d c = _mm_sub_pd(_mm_mul_pd(rx, dy), _mm_mul_pd(ry, dx));
+    __m128d m = _mm_mul_pd(c, c);
+    __m128d gt = _mm_cmpgt_pd(m, best);
+    best = _mm_or_pd(_mm_and_pd(gt, m), _mm_andnot_pd(gt, best));
+    bestIndex = _mm_or_pd(_mm_and_pd(gt, index), _mm_andnot_pd(gt, bestIndex));
+    index = _mm_add_pd(index, step);
+  }
+
+  double lb[2], li[2], t = 0;
+  _mm_storeu_pd(lb, best);
+  _mm_storeu_pd(li, bestIndex);
+  int ti = argmax_scalar(xy, i, last, seg, &t);
+  return reduce_lanes(lb, li, 2, ti, t, metric);
+}
+
+__attribute__((target("avx2"))) static int
+argmax_avx2(double const *xy, int first, int last,
+            struct rdp_segment const *seg, double *metric) {
+  __m256d sx = _mm256_set1_pd(seg->sx), sy = _mm256_set1_pd(seg->sy);
+  __m256d dx = _mm256_set1_pd(seg->dx), dy = _mm256_set1_pd(seg->dy);
+  // two independent accumulators hide the latency of the compare and blend
+  __m256d best0 = _mm256_setzero_pd(), best1 = _mm256_setzero_pd();
+  __m256d bestIndex0 = _mm256_set1_pd(-1), bestIndex1 = _mm256_set1_pd(-1);
+  // unpacking pairs of points leaves the lanes in the order 0, 2, 1, 3
+  __m256d index0 = _mm256_add_pd(_mm256_set1_pd(first),
+                                 _mm256_setr_pd(0, 2, 1, 3));
+  __m256d index1 = _mm256_add_pd(index0, _mm256_set1_pd(4));
+  __m256d step = _mm256_set1_pd(8);
+
+  int i = first;
+  for (; i + 8 <= last; i += 8) {
+    double const *p = xy + 2 * i;
+    __m256d a0 = _mm256_loadu_pd(p), b0 = _mm256_loadu_pd(p + 4);
+    __m256d a1 = _mm256_loadu_pd(p + 8), b1 = _mm256_loadu_pd(p + 12);
+
+    __m256d rx0 = _mm256_sub_pd(_mm256_unpacklo_pd(a0, b0), sx);
+    __m256d ry0 = _mm256_sub_pd(_mm256_unpackhi_pd(a0, b0), sy);
+    __m256d rx1 = _mm256_sub_pd(_mm256_unpacklo_pd(a1, b1), sx);
+    __m256d ry1 = _mm256_sub_pd(_mm256_unpackhi_pd(a1, b1), sy);
+
+    __m256d c0 = _mm256_sub_pd(_mm256_mul_pd(rx0, dy), _mm256_mul_pd(ry0, dx));
+    __m256d c1 = _mm256_sub_pd(_mm256_mul_pd(rx1, dy), _mm256_mul_pd(ry1, dx));
+    __m256d m0 = _mm256_mul_pd(c0, c0);
+    __m256d m1 = _mm256_mul_pd(c1, c1);
+
+    __m256d gt0 = _mm256_cmp_pd(m0, best0, _CMP_GT_OQ);
+    __m256d gt1 = _mm256_cmp_pd(m1, best1, _CMP_GT_OQ);
+    best0 = _mm256_blendv_pd(best0, m0, gt0);
+    best1 = _mm256_blendv_pd(best1, m1, gt1);
+    bestIndex0 = _mm256_blendv_pd(bestIndex0, index0, gt0);
+    bestIndex1 = _mm256_blendv_pd(bestIndex1, index1, gt1);
+
+    index0 = _mm256_add_pd(index0, step);
+    index1 = _mm256_add_pd(index1, step);
+  }
+
+  double lb[8], li[8], t = 0;
+  _mm256_storeu_pd(lb, best0);
+  _mm256_storeu_pd(lb + 4, best1);
+  _mm256_storeu_pd(li, bestIndex0);
+  _mm256_storeu_pd(li + 4, bestIndex1);
+  // the scalar tail and the caller may run legacy SSE code, which stalls
+  // while the upper halves of the vector registers are dirty
+  _mm256_zeroupper();
+  int ti = argmax_scalar(xy, i, last, seg, &t);
+  return reduce_lanes(lb, li, 8, ti, t, metric);
+}
+
+__attribute__((target("avx512f"))) static int
+argmax_avx512(double const *xy, int first, int last,
+              struct rdp_segment const *seg, double *metric) {
+  __m512d sx = _mm512_set1_pd(seg->sx), sy = _mm512_set1_pd(seg->sy);
+  __m512d dx = _mm512_set1_pd(seg->dx), dy = _mm512_set1_pd(seg->dy);
+  __m512d best0 = _mm512_setzero_pd(), best1 = _mm512_setzero_pd();
+  __m512d bestIndex0 = _mm512_set1_pd(-1), bestIndex1 = _mm512_set1_pd(-1);
+  // unpacking within 128 bit lanes leaves the points in this order
+  __m512d index0 = _mm512_add_pd(_mm512_set1_pd(first),
+                                 _mm512_setr_pd(0, 4, 1, 5, 2, 6, 3, 7));
+  __m512d index1 = _mm512_add_pd(index0, _mm512_set1_pd(8));
+  __m512d step = _mm512_set1_pd(16);
+
+  int i = first;
+  for (; i + 16 <= last; i += 16) {
+    double const *p = xy + 2 * i;
+    __m512d a0 = _mm512_loadu_pd(p), b0 = _mm512_loadu_pd(p + 8);
+    __m512d a1 = _mm512_loadu_pd(p + 16), b1 = _mm512_loadu_pd(p + 24);
+
+    __m512d rx0 = _mm512_sub_pd(_mm512_unpacklo_pd(a0, b0), sx);
+    __m512d ry0 = _mm512_sub_pd(_mm512_unpackhi_pd(a0, b0), sy);
+    __m512d rx1 = _mm512_sub_pd(_mm512_unpacklo_pd(a1, b1), sx);
+    __m512d ry1 = _mm512_sub_pd(_mm512_unpackhi_pd(a1, b1), sy);
+
+    __m512d c0 = _mm512_sub_pd(_mm512_mul_pd(rx0, dy), _mm512_mul_pd(ry0, dx));
+    __m512d c1 = _mm512_sub_pd(_mm512_mul_pd(rx1, dy), _mm512_mul_pd(ry1, dx));
+    __m512d m0 = _mm512_mul_pd(c0, c0);
+    __m512d m1 = _mm512_mul_pd(c1, c1);
+
+    __mmask8 gt0 = _mm512_cmp_pd_mask(m0, best0, _CMP_GT_OQ);
+    __mmask8 gt1 = _mm512_cmp_pd_mask(m1, best1, _CMP_GT_OQ);
+    best0 = _mm512_mask_mov_pd(best0, gt0, m0);
+    best1 = _mm512_mask_mov_pd(best1, gt1, m1);
+    bestIndex0 = _mm512_mask_mov_pd(bestIndex0, gt0, index0);
+    bestIndex1 = _mm512_mask_mov_pd(bestIndex1, gt1, index1);
+
+    index0 = _mm512_add_pd(index0, step);
+    index1 = _mm512_add_pd(index1, step);
+  }
+
+  double lb[16], li[16], t = 0;
+  _mm512_storeu_pd(lb, best0);
+  _mm512_storeu_pd(lb + 8, best1);
+  _mm512_storeu_pd(li, bestIndex0);
+  _mm512_storeu_pd(li + 8, bestIndex1);
+  _mm256_zeroupper();
+  int ti = argmax_scalar(xy, i, last, seg, &t);
+  return reduce_lanes(lb, li, 16, ti, t, metric);
+}
+
+/*
+ * The structure of arrays versions load x and y directly, so the lanes stay
+ * in index order.
+ */
+
+__attribute__((target("sse2"))) static int
+argmax_soa_sse2(double const *xs, double const *ys, int first, int last,
+                struct rdp_segment const *seg, double *metric) {
+  __m128d sx = _mm_set1_pd(seg->sx), sy = _mm_set1_pd(seg->sy);
+  __m128d dx = _mm_set1_pd(seg->dx), dy = _mm_set1_pd(seg->dy);
+  __m128d best = _mm_setzero_pd();
+  __m128d bestIndex = _mm_set1_pd(-1);
+  __m128d index = _mm_set_pd(first + 1, first);
+  __m128d step = _mm_set1_pd(2);
+
+  int i = first;
+  for (; i + 2 <= last; i += 2) {
+    __m128d rx = _mm_sub_pd(_mm_loadu_pd(xs + i), sx);
+    __m128d ry = _mm_sub_pd(_mm_loadu_pd(ys + i), sy);
+    __m128d c = _mm_sub_pd(_mm_mul_pd(rx, dy), _mm_mul_pd(ry, dx));
+    __m128d m = _mm_mul_pd(c, c);
+    __m128d gt = _mm_cmpgt_pd(m, best);
+    best = _mm_or_pd(_mm_and_pd(gt, m), _mm_andnot_pd(gt, best));
+    bestIndex = _mm_or_pd(_mm_and_pd(gt, index), _mm_andnot_pd(gt, bestIndex));
+    index = _mm_add_pd(index, step);
+  }
+
+  double lb[2], li[2], t = 0;
+  _mm_storeu_pd(lb, best);
+  _mm_storeu_pd(li, bestIndex);
+  int ti = argmax_soa_scalar(xs, ys, i, last, seg, &t);
+  return reduce_lanes(lb, li, 2, ti, t, metric);
+}
+
+__attribute__((target("avx2"))) static int
+argmax_soa_avx2(double const *xs, double const *ys, int first, int last,
+                struct rdp_segment const *seg, double *metric) {
+  __m256d sx = _mm256_set1_pd(seg->sx), sy = _mm256_set1_pd(seg->sy);
+  __m256d dx = _mm256_set1_pd(seg->dx), dy = _mm256_set1_pd(seg->dy);
+  __m256d best0 = _mm256_setzero_pd(), best1 = _mm256_setzero_pd();
+  __m256d bestIndex0 = _mm256_set1_pd(-1), bestIndex1 = _mm256_set1_pd(-1);
+  __m256d index0 = _mm256_add_pd(_mm256_set1_pd(first),
+                                 _mm256_setr_pd(0, 1, 2, 3));
+  __m256d index1 = _mm256_add_pd(index0, _mm256_set1_pd(4));
+  __m256d step = _mm256_set1_pd(8);
+
+  int i = first;
+  for (; i + 8 <= last; i += 8) {
+    __m256d rx0 = _mm256_sub_pd(_mm256_loadu_pd(xs + i), sx);
+    __m256d ry0 = _mm256_sub_pd(_mm256_loadu_pd(ys + i), sy);
+    __m256d rx1 = _mm256_sub_pd(_mm256_loadu_pd(xs + i + 4), sx);
+    __m256d ry1 = _mm256_sub_pd(_mm256_loadu_pd(ys + i + 4), sy);
+
+    __m256d c0 = _mm256_sub_pd(_mm256_mul_pd(rx0, dy), _mm256_mul_pd(ry0, dx));
+    __m256d c1 = _mm256_sub_pd(_mm256_mul_pd(rx1, dy), _mm256_mul_pd(ry1, dx));
+    __m256d m0 = _mm256_mul_pd(c0, c0);
+    __m256d m1 = _mm256_mul_pd(c1, c1);
+
+    __m256d gt0 = _mm256_cmp_pd(m0, best0, _CMP_GT_OQ);
+    __m256d gt1 = _mm256_cmp_pd(m1, best1, _CMP_GT_OQ);
+    best0 = _mm256_blendv_pd(best0, m0, gt0);
+    best1 = _mm256_blendv_pd(best1, m1, gt1);
+    bestIndex0 = _mm256_blendv_pd(bestIndex0, index0, gt0);
+    bestIndex1 = _mm256_blendv_pd(bestIndex1, index1, gt1);
+
+    index0 = _mm256_add_pd(index0, step);
+    index1 = _mm256_add_pd(index1, step);
+  }
+
+  double lb[8], li[8], t = 0;
+  _mm256_storeu_pd(lb, best0);
+  _mm256_storeu_pd(lb + 4, best1);
+  _mm256_storeu_pd(li, bestIndex0);
+  _mm256_storeu_pd(li + 4, bestIndex1);
+  _mm256_zeroupper();
+  int ti = argmax_soa_scalar(xs, ys, i, last, seg, &t);
+  return reduce_lanes(lb, li, 8, ti, t, metric);
+}
+
+__attribute__((target("avx512f"))) static int
+argmax_soa_avx512(double const *xs, double const *ys, int first, int last,
+                  struct rdp_segment const *seg, double *metric) {
+  __m512d sx = _mm512_set1_pd(seg->sx), sy = _mm512_set1_pd(seg->sy);
+  __m512d dx = _mm512_set1_pd(seg->dx), dy = _mm512_set1_pd(seg->dy);
+  __m512d best0 = _mm512_setzero_pd(), best1 = _mm512_setzero_pd();
+  __m512d bestIndex0 = _mm512_set1_pd(-1), bestIndex1 = _mm512_set1_pd(-1);
+  __m512d index0 = _mm512_add_pd(_mm512_set1_pd(first),
+                                 _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7));
+  __m512d index1 = _mm512_add_pd(index0, _mm512_set1_pd(8));
+  __m512d step = _mm512_set1_pd(16);
+
+  int i = first;
+  for (; i + 16 <= last; i += 16) {
+    __m512d rx0 = _mm512_sub_pd(_mm512_loadu_pd(xs + i), sx);
+    __m512d ry0 = _mm512_sub_pd(_mm512_loadu_pd(ys + i), sy);
+    __m512d rx1 = _mm512_sub_pd(_mm512_loadu_pd(xs + i + 8), sx);
+    __m512d ry1 = _mm512_sub_pd(_mm512_loadu_pd(ys + i + 8), sy);
+
+    __m512d c0 = _mm512_sub_pd(_mm512_mul_pd(rx0, dy), _mm512_mul_pd(ry0, dx));
+    __m512d c1 = _mm512_sub_pd(_mm512_mul_pd(rx1, dy), _mm512_mul_pd(ry1, dx));
+    __m512d m0 = _mm512_mul_pd(c0, c0);
+    __m512d m1 = _mm512_mul_pd(c1, c1);
+
+    __mmask8 gt0 = _mm512_cmp_pd_mask(m0, best0, _CMP_GT_OQ);
+    __mmask8 gt1 = _mm512_cmp_pd_mask(m1, best1, _CMP_GT_OQ);
+    best0 = _mm512_mask_mov_pd(best0, gt0, m0);
+    best1 = _mm512_mask_mov_pd(best1, gt1, m1);
+    bestIndex0 = _mm512_mask_mov_pd(bestIndex0, gt0, index0);
+    bestIndex1 = _mm512_mask_mov_pd(bestIndex1, gt1, index1);
+
+    index0 = _mm512_add_pd(index0, step);
+    index1 = _mm512_add_pd(index1, step);
+  }
+
+  double lb[16], li[16], t = 0;
+  _mm512_storeu_pd(lb, best0);
+  _mm512_storeu_pd(lb + 8, best1);
+  _mm512_storeu_pd(li, bestIndex0);
+  _mm512_storeu_pd(li + 8, bestIndex1);
+  _mm256_zeroupper();
+  int ti = argmax_soa_scalar(xs, ys, i, last, seg, &t);
+  return reduce_lanes(lb, li, 16, ti, t, metric);
+}
+
+/*
+ * Float versions of the kernels above. Only the loads differ: each one
+ * widens floats to doubles in the same lane order the double kernels load
+ * them in, so the rest of every loop is unchanged.
+ */
+
+__attribute__((target("sse2"))) static int
+argmax_f32_sse2(float const *xy, int first, int last,
+                struct rdp_segment const *seg, double *metric) {
+  __m128d sx = _mm_set1_pd(seg->sx), sy = _mm_set1_pd(seg->sy);
+  __m128d dx = _mm_set1_pd(seg->dx), dy = _mm_set1_pd(seg->dy);
+  __m128d best = _mm_setzero_pd();
+  __m128d bestIndex = _mm_set1_pd(-1);
+  __m128d index = _mm_set_pd(first + 1, first);
+  __m128d step = _mm_set1_pd(2);
+
+  int i = first;
+  for (; i + 2 <= last; i += 2) {
+    __m128 v = _mm_loadu_ps(xy + 2 * i);
+    __m128d a = _mm_cvtps_pd(v);
+    __m128d b = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+    __m128d rx = _mm_sub_pd(_mm_unpacklo_pd(a, b), sx);
+    __m128d ry = _mm_sub_pd(_mm_unpackhi_pd(a, b), sy);
+    __m128d c = _mm_sub_pd(_mm_mul_pd(rx, dy), _mm_mul_pd(ry, dx));
+    __m128d m = _mm_mul_pd(c, c);
+    __m128d gt = _mm_cmpgt_pd(m, best);
+    best = _mm_or_pd(_mm_and_pd(gt, m), _mm_andnot_pd(gt, best));
+    bestIndex = _mm_or_pd(_mm_and_pd(gt, index), _mm_andnot_pd(gt, bestIndex));
+    index = _mm_add_pd(index, step);
+  }
+
+  double lb[2], li[2], t = 0;
+  _mm_storeu_pd(lb, best);
+  _mm_storeu_pd(li, bestIndex);
+  int ti = argmax_f32_scalar(xy, i, last, seg, &t);
+  return reduce_lanes(lb, li, 2, ti, t, metric);
+}
+
+__attribute__((target("avx2"))) static int
+argmax_f32_avx2(float const *xy, int first, int last,
+                struct rdp_segment const *seg, double *metric) {
+  __m256d sx = _mm256_set1_pd(seg->sx), sy = _mm256_set1_pd(seg->sy);
+  __m256d dx = _mm256_set1_pd(seg->dx), dy = _mm256_set1_pd(seg->dy);
+  __m256d best0 = _mm256_setzero_pd(), best1 = _mm256_setzero_pd();
+  __m256d bestIndex0 = _mm256_set1_pd(-1), bestIndex1 = _mm256_set1_pd(-1);
+  __m256d index0 = _mm256_add_pd(_mm256_set1_pd(first),
+                                 _mm256_setr_pd(0, 2, 1, 3));
+  __m256d index1 = _mm256_add_pd(index0, _mm256_set1_pd(4));
+  __m256d step = _mm256_set1_pd(8);
+
+  int i = first;
+  for (; i + 8 <= last; i += 8) {
+    float const *p = xy + 2 * i;
+    __m256d a0 = _mm256_cvtps_pd(_mm_loadu_ps(p));
+    __m256d b0 = _mm256_cvtps_pd(_mm_loadu_ps(p + 4));
+    __m256d a1 = _mm256_cvtps_pd(_mm_loadu_ps(p + 8));
+    __m256d b1 = _mm256_cvtps_pd(_mm_loadu_ps(p + 12));
+
+    __m256d rx0 = _mm256_sub_pd(_mm256_unpacklo_pd(a0, b0), sx);
+    __m256d ry0 = _mm256_sub_pd(_mm256_unpackhi_pd(a0, b0), sy);
+    __m256d rx1 = _mm256_sub_pd(_mm256_unpacklo_pd(a1, b1), sx);
+    __m256d ry1 = _mm256_sub_pd(_mm256_unpackhi_pd(a1, b1), sy);
+
+    __m256d c0 = _mm256_sub_pd(_mm256_mul_pd(rx0, dy), _mm256_mul_pd(ry0, dx));
+    __m256d c1 = _mm256_sub_pd(_mm256_mul_pd(rx1, dy), _mm256_mul_pd(ry1, dx));
+    __m256d m0 = _mm256_mul_pd(c0, c0);
+    __m256d m1 = _mm256_mul_pd(c1, c1);
+
+    __m256d gt0 = _mm256_cmp_pd(m0, best0, _CMP_GT_OQ);
+    __m256d gt1 = _mm256_cmp_pd(m1, best1, _CMP_GT_OQ);
+    best0 = _mm256_blendv_pd(best0, m0, gt0);
+    best1 = _mm256_blendv_pd(best1, m1, gt1);
+    bestIndex0 = _mm256_blendv_pd(bestIndex0, index0, gt0);
+    bestIndex1 = _mm256_blendv_pd(bestIndex1, index1, gt1);
+
+    index0 = _mm256_add_pd(index0, step);
+    index1 = _mm256_add_pd(index1, step);
+  }
+
+  double lb[8], li[8], t = 0;
+  _mm256_storeu_pd(lb, best0);
+  _mm256_storeu_pd(lb + 4, best1);
+  _mm256_storeu_pd(li, bestIndex0);
+  _mm256_storeu_pd(li + 4, bestIndex1);
+  _mm256_zeroupper();
+  int ti = argmax_f32_scalar(xy, i, last, seg, &t);
+  return reduce_lanes(lb, li, 8, ti, t, metric);
+}
+
+__attribute__((target("avx512f"))) static int
+argmax_f32_avx512(float const *xy, int first, int last,
+                  struct rdp_segment const *seg, double *metric) {
+  __m512d sx = _mm512_set1_pd(seg->sx), sy = _mm512_set1_pd(seg->sy);
+  __m512d dx = _mm512_set1_pd(seg->dx), dy = _mm512_set1_pd(seg->dy);
+  __m512d best0 = _mm512_setzero_pd(), best1 = _mm512_setzero_pd();
+  __m512d bestIndex0 = _mm512_set1_pd(-1), bestIndex1 = _mm512_set1_pd(-1);
+  __m512d index0 = _mm512_add_pd(_mm512_set1_pd(first),
+                                 _mm512_setr_pd(0, 4, 1, 5, 2, 6, 3, 7));
+  __m512d index1 = _mm512_add_pd(index0, _mm512_set1_pd(8));
+  __m512d step = _mm512_set1_pd(16);
+
+  int i = first;
+  for (; i + 16 <= last; i += 16) {
+    float const *p = xy + 2 * i;
+    __m512d a0 = _mm512_cvtps_pd(_mm256_loadu_ps(p));
+    __m512d b0 = _mm512_cvtps_pd(_mm256_loadu_ps(p + 8));
+    __m512d a1 = _mm512_cvtps_pd(_mm256_loadu_ps(p + 16));
+    __m512d b1 = _mm512_cvtps_pd(_mm256_loadu_ps(p + 24));
+
+    __m512d rx0 = _mm512_sub_pd(_mm512_unpacklo_pd(a0, b0), sx);
+    __m512d ry0 = _mm512_sub_pd(_mm512_unpackhi_pd(a0, b0), sy);
+    __m512d rx1 = _mm512_sub_pd(_mm512_unpacklo_pd(a1, b1), sx);
+    __m512d ry1 = _mm512_sub_pd(_mm512_unpackhi_pd(a1, b1), sy);
+
+    __m512d c0 = _mm512_sub_pd(_mm512_mul_pd(rx0, dy), _mm512_mul_pd(ry0, dx));
+    __m512d c1 = _mm512_sub_pd(_mm512_mul_pd(rx1, dy), _mm512_mul_pd(ry1, dx));
+    __m512d m0 = _mm512_mul_pd(c0, c0);
+    __m512d m1 = _mm512_mul_pd(c1, c1);
+
+    __mmask8 gt0 = _mm512_cmp_pd_mask(m0, best0, _CMP_GT_OQ);
+    __mmask8 gt1 = _mm512_cmp_pd_mask(m1, best1, _CMP_GT_OQ);
+    best0 = _mm512_mask_mov_pd(best0, gt0, m0);
+    best1 = _mm512_mask_mov_pd(best1, gt1, m1);
+    bestIndex0 = _mm512_mask_mov_pd(bestIndex0, gt0, index0);
+    bestIndex1 = _mm512_mask_mov_pd(bestIndex1, gt1, index1);
+
+    index0 = _mm512_add_pd(index0, step);
+    index1 = _mm512_add_pd(index1, step);
+  }
+
+  double lb[16], li[16], t = 0;
+  _mm512_storeu_pd(lb, best0);
+  _mm512_storeu_pd(lb + 8, best1);
+  _mm512_storeu_pd(li, bestIndex0);
+  _mm512_storeu_pd(li + 8, bestIndex1);
+  _mm256_zeroupper();
+  int ti = argmax_f32_scalar(xy, i, last, seg, &t);
+  return reduce_lanes(lb, li, 16, ti, t, metric);
+}
+
+__attribute__((target("sse2"))) static int
+argmax_soa_f32_sse2(float const *xs, float const *ys, int first, int last,
+                    struct rdp_segment const *seg, double *metric) {
+  __m128d sx = _mm_set1_pd(seg->sx), sy = _mm_set1_pd(seg->sy);
+  __m128d dx = _mm_set1_pd(seg->dx), dy = _mm_set1_pd(seg->dy);
+  __m128d best = _mm_setzero_pd();
+  __m128d bestIndex = _mm_set1_pd(-1);
+  __m128d index = _mm_set_pd(first + 1, first);
+  __m128d step = _mm_set1_pd(2);
+
+  int i = first;
+  for (; i + 2 <= last; i += 2) {
+    __m128d x = _mm_cvtps_pd(
+        _mm_castsi128_ps(_mm_loadl_epi64((__m128i const *)(xs + i))));
+    __m128d y = _mm_cvtps_pd(
+        _mm_castsi128_ps(_mm_loadl_epi64((__m128i const *)(ys + i))));
+    __m128d rx = _mm_sub_pd(x, sx);
+    __m128d ry = _mm_sub_pd(y, sy);
+    __m128d c = _mm_sub_pd(_mm_mul_pd(rx, dy), _mm_mul_pd(ry, dx));
+    __m128d m = _mm_mul_pd(c, c);
+    __m128d gt = _mm_cmpgt_pd(m, best);
+    best = _mm_or_pd(_mm_and_pd(gt, m), _mm_andnot_pd(gt, best));
+    bestIndex = _mm_or_pd(_mm_and_pd(gt, index), _mm_andnot_pd(gt, bestIndex));
+    index = _mm_add_pd(index, step);
+  }
+
+  double lb[2], li[2], t = 0;
+  _mm_storeu_pd(lb, best);
+  _mm_storeu_pd(li, bestIndex);
+  int ti = argmax_soa_f32_scalar(xs, ys, i, last, seg, &t);
+  return reduce_lanes(lb, li, 2, ti, t, metric);
+}
+
+__attribute__((target("avx2"))) static int
+argmax_soa_f32_avx2(float const *xs, float const *ys, int first, int last,
+                    struct rdp_segment const *seg, double *metric) {
+  __m256d sx = _mm256_set1_pd(seg->sx), sy = _mm256_set1_pd(seg->sy);
+  __m256d dx = _mm256_set1_pd(seg->dx), dy = _mm256_set1_pd(seg->dy);
+  __m256d best0 = _mm256_setzero_pd(), best1 = _mm256_setzero_pd();
+  __m256d bestIndex0 = _mm256_set1_pd(-1), bestIndex1 = _mm256_set1_pd(-1);
+  __m256d index0 = _mm256_add_pd(_mm256_set1_pd(first),
+                                 _mm256_setr_pd(0, 1, 2, 3));
+  __m256d index1 = _mm256_add_pd(index0, _mm256_set1_pd(4));
+  __m256d step = _mm256_set1_pd(8);
+
+  int i = first;
+  for (; i + 8 <= last; i += 8) {
+    __m256d rx0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(xs + i)), sx);
+    __m256d ry0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(ys + i)), sy);
+    __m256d rx1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(xs + i + 4)), sx);
+    __m256d ry1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(ys + i + 4)), sy);
+
+    __m256d c0 = _mm256_sub_pd(_mm256_mul_pd(rx0, dy), _mm256_mul_pd(ry0, dx));
+    __m256d c1 = _mm256_sub_pd(_mm256_mul_pd(rx1, dy), _mm256_mul_pd(ry1, dx));
+    __m256d m0 = _mm256_mul_pd(c0, c0);
+    __m256d m1 = _mm256_mul_pd(c1, c1);
+
+    __m256d gt0 = _mm256_cmp_pd(m0, best0, _CMP_GT_OQ);
+    __m256d gt1 = _mm256_cmp_pd(m1, best1, _CMP_GT_OQ);
+    best0 = _mm256_blendv_pd(best0, m0, gt0);
+    best1 = _mm256_blendv_pd(best1, m1, gt1);
+    bestIndex0 = _mm256_blendv_pd(bestIndex0, index0, gt0);
+    bestIndex1 = _mm256_blendv_pd(bestIndex1, index1, gt1);
+
+    index0 = _mm256_add_pd(index0, step);
+    index1 = _mm256_add_pd(index1, step);
+  }
+
+  double lb[8], li[8], t = 0;
+  _mm256_storeu_pd(lb, best0);
+  _mm256_storeu_pd(lb + 4, best1);
+  _mm256_storeu_pd(li, bestIndex0);
+  _mm256_storeu_pd(li + 4, bestIndex1);
+  _mm256_zeroupper();
+  int ti = argmax_soa_f32_scalar(xs, ys, i, last, seg, &t);
+  return reduce_lanes(lb, li, 8, ti, t, metric);
+}
+
+__attribute__((target("avx512f"))) static int
+argmax_soa_f32_avx512(float const *xs, float const *ys, int first, int last,
+                      struct rdp_segment const *seg, double *metric) {
+  __m512d sx = _mm512_set1_pd(seg->sx), sy = _mm512_set1_pd(seg->sy);
+  __m512d dx = _mm512_set1_pd(seg->dx), dy = _mm512_set1_pd(seg->dy);
+  __m512d best0 = _mm512_setzero_pd(), best1 = _mm512_setzero_pd();
+  __m512d bestIndex0 = _mm512_set1_pd(-1), bestIndex1 = _mm512_set1_pd(-1);
+  __m512d index0 = _mm512_add_pd(_mm512_set1_pd(first),
+                                 _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7));
+  __m512d index1 = _mm512_add_pd(index0, _mm512_set1_pd(8));
+  __m512d step = _mm512_set1_pd(16);
+
+  int i = first;
+  for (; i + 16 <= last; i += 16) {
+    __m512d rx0 =
+        _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(xs + i)), sx);
+    __m512d ry0 =
+        _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(ys + i)), sy);
+    __m512d rx1 =
+        _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(xs + i + 8)), sx);
+    __m512d ry1 =
+        _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(ys + i + 8)), sy);
+
+    __m512d c0 = _mm512_sub_pd(_mm512_mul_pd(rx0, dy), _mm512_mul_pd(ry0, dx));
+    __m512d c1 = _mm512_sub_pd(_mm512_mul_pd(rx1, dy), _mm512_mul_pd(ry1, dx));
+    __m512d m0 = _mm512_mul_pd(c0, c0);
+    __m512d m1 = _mm512_mul_pd(c1, c1);
+
+    __mmask8 gt0 = _mm512_cmp_pd_mask(m0, best0, _CMP_GT_OQ);
+    __mmask8 gt1 = _mm512_cmp_pd_mask(m1, best1, _CMP_GT_OQ);
+    best0 = _mm512_mask_mov_pd(best0, gt0, m0);
+    best1 = _mm512_mask_mov_pd(best1, gt1, m1);
+    bestIndex0 = _mm512_mask_mov_pd(bestIndex0, gt0, index0);
+    bestIndex1 = _mm512_mask_mov_pd(bestIndex1, gt1, index1);
+
+    index0 = _mm512_add_pd(index0, step);
+    index1 = _mm512_add_pd(index1, step);
+  }
+
+  double lb[16], li[16], t = 0;
+  _mm512_storeu_pd(lb, best0);
+  _mm512_storeu_pd(lb + 8, best1);
+  _mm512_storeu_pd(li, bestIndex0);
+  _mm512_storeu_pd(li + 8, bestIndex1);
+  _mm256_zeroupper();
+  int ti = argmax_soa_f32_scalar(xs, ys, i, last, seg, &t);
+  return reduce_lanes(lb, li, 16, ti, t, metric);
+}
+
+/*
+ * min and max give the same answer in any order for values that are not NaN
+ * so the lanes only need a final horizontal reduction.
+ */
+
+/*
+ * Finishes a vectorized minmax with the values the lanes did not cover
+ */
+static void minmax_tail(double const *values, int first, int length,
+                        double *min, double *max) {
+  for (int i = first; i < length; i++) {
+    if (values[i] < *min)
+      *min = values[i];
+    if (values[i] > *max)
+      *max = values[i];
+  }
+}
+
+__attribute__((target("sse2"))) static void
+minmax_sse2(double const *values, int length, double *min, double *max) {
+  __m128d lo = _mm_set1_pd(values[0]), hi = lo;
+  int i = 0;
+  for (; i + 2 <= length; i += 2) {
+    __m128d v = _mm_loadu_pd(values + i);
+    lo = _mm_min_pd(lo, v);
+    hi = _mm_max_pd(hi, v);
+  }
+  double l[2], h[2];
+  _mm_storeu_pd(l, lo);
+  _mm_storeu_pd(h, hi);
+  *min = l[0] < l[1] ? l[0] : l[1];
+  *max = h[0] > h[1] ? h[0] : h[1];
+  minmax_tail(values, i, length, min, max);
+}
+
+__attribute__((target("avx2"))) static void
+minmax_avx2(double const *values, int length, double *min, double *max) {
+  __m256d lo0 = _mm256_set1_pd(values[0]), hi0 = lo0, lo1 = lo0, hi1 = lo0;
+  int i = 0;
+  for (; i + 8 <= length; i += 8) {
+    __m256d v0 = _mm256_loadu_pd(values + i);
+    __m256d v1 = _mm256_loadu_pd(values + i + 4);
+    lo0 = _mm256_min_pd(lo0, v0);
+    hi0 = _mm256_max_pd(hi0, v0);
+    lo1 = _mm256_min_pd(lo1, v1);
+    hi1 = _mm256_max_pd(hi1, v1);
+  }
+  double l[4], h[4];
+  _mm256_storeu_pd(l, _mm256_min_pd(lo0, lo1));
+  _mm256_storeu_pd(h, _mm256_max_pd(hi0, hi1));
+  *min = l[0];
+  *max = h[0];
+  minmax_tail(l, 1, 4, min, max);
+  minmax_tail(h, 1, 4, min, max);
+  minmax_tail(values, i, length, min, max);
+}
+
+__attribute__((target("avx512f"))) static void
+minmax_avx512(double const *values, int length, double *min, double *max) {
+  __m512d lo0 = _mm512_set1_pd(values[0]), hi0 = lo0, lo1 = lo0, hi1 = lo0;
+  int i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m512d v0 = _mm512_loadu_pd(values + i);
+    __m512d v1 = _mm512_loadu_pd(values + i + 8);
+    lo0 = _mm512_min_pd(lo0, v0);
+    hi0 = _mm512_max_pd(hi0, v0);
+    lo1 = _mm512_min_pd(lo1, v1);
+    hi1 = _mm512_max_pd(hi1, v1);
+  }
+  *min = _mm512_reduce_min_pd(_mm512_min_pd(lo0, lo1));
+  *max = _mm512_reduce_max_pd(_mm512_max_pd(hi0, hi1));
+  minmax_tail(values, i, length, min, max);
+}
+
+/*
+ * The float minmax kernels compare floats directly, which is exact, so they
+ * fit twice as many values in each vector as the double ones.
+ */
+
+static void minmax_f32_tail(float const *values, int first, int length,
+                            float *min, float *max) {
+  for (int i = first; i < length; i++) {
+    if (values[i] < *min)
+      *min = values[i];
+    if (values[i] > *max)
+      *max = values[i];
+  }
+}
+
+__attribute__((target("sse2"))) static void
+minmax_f32_sse2(float const *values, int length, float *min, float *max) {
+  __m128 lo = _mm_set1_ps(values[0]), hi = lo;
+  int i = 0;
+  for (; i + 4 <= length; i += 4) {
+    __m128 v = _mm_loadu_ps(values + i);
+    lo = _mm_min_ps(lo, v);
+    hi = _mm_max_ps(hi, v);
+  }
+  float l[4], h[4];
+  _mm_storeu_ps(l, lo);
+  _mm_storeu_ps(h, hi);
+  *min = l[0];
+  *max = h[0];
+  minmax_f32_tail(l, 1, 4, min, max);
+  minmax_f32_tail(h, 1, 4, min, max);
+  minmax_f32_tail(values, i, length, min, max);
+}
+
+__attribute__((target("avx2"))) static void
+minmax_f32_avx2(float const *values, int length, float *min, float *max) {
+  __m256 lo0 = _mm256_set1_ps(values[0]), hi0 = lo0, lo1 = lo0, hi1 = lo0;
+  int i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m256 v0 = _mm256_loadu_ps(values + i);
+    __m256 v1 = _mm256_loadu_ps(values + i + 8);
+    lo0 = _mm256_min_ps(lo0, v0);
+    hi0 = _mm256_max_ps(hi0, v0);
+    lo1 = _mm256_min_ps(lo1, v1);
+    hi1 = _mm256_max_ps(hi1, v1);
+  }
+  float l[8], h[8];
+  _mm256_storeu_ps(l, _mm256_min_ps(lo0, lo1));
+  _mm256_storeu_ps(h, _mm256_max_ps(hi0, hi1));
+  *min = l[0];
+  *max = h[0];
+  minmax_f32_tail(l, 1, 8, min, max);
+  minmax_f32_tail(h, 1, 8, min, max);
+  minmax_f32_tail(values, i, length, min, max);
+}
+
+__attribute__((target("avx512f"))) static void
+minmax_f32_avx512(float const *values, int length, float *min, float *max) {
+  __m512 lo0 = _mm512_set1_ps(values[0]), hi0 = lo0, lo1 = lo0, hi1 = lo0;
+  int i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m512 v0 = _mm512_loadu_ps(values + i);
+    __m512 v1 = _mm512_loadu_ps(values + i + 16);
+    lo0 = _mm512_min_ps(lo0, v0);
+    hi0 = _mm512_max_ps(hi0, v0);
+    lo1 = _mm512_min_ps(lo1, v1);
+    hi1 = _mm512_max_ps(hi1, v1);
+  }
+  *min = _mm512_reduce_min_ps(_mm512_min_ps(lo0, lo1));
+  *max = _mm512_reduce_max_ps(_mm512_max_ps(hi0, hi1));
+  minmax_f32_tail(values, i, length, min, max);
+}
+
+#endif
+
+static bool isa_supported(enum rdp_kernel_isa isa) {
+  switch (isa) {
+  case RDP_KERNEL_SCALAR:
+    return true;
+#ifdef RDP_KERNEL_X86
+  case RDP_KERNEL_SSE2:
+    return __builtin_cpu_supports("sse2");
+  case RDP_KERNEL_AVX2:
+    return __builtin_cpu_supports("avx2");
+  case RDP_KERNEL_AVX512:
+    return __builtin_cpu_supports("avx512f");
+#endif
+  default:
+    return false;
+  }
+}
+
+struct kernel_table {
+  argmax_fn argmax;
+  argmax_soa_fn argmax_soa;
+  minmax_fn minmax;
+  argmax_f32_fn argmax_f32;
+  argmax_soa_f32_fn argmax_soa_f32;
+  minmax_f32_fn minmax_f32;
+};
+
+static struct kernel_table const scalar_table = {
+    argmax_scalar,     argmax_soa_scalar,     minmax_scalar,
+    argmax_f32_scalar, argmax_soa_f32_scalar, minmax_f32_scalar};
+
+static struct kernel_table isa_table(enum rdp_kernel_isa isa) {
+  switch (isa) {
+#ifdef RDP_KERNEL_X86
+  case RDP_KERNEL_SSE2:
+    return (struct kernel_table){argmax_sse2,     argmax_soa_sse2,
+                                 minmax_sse2,     argmax_f32_sse2,
+                                 argmax_soa_f32_sse2, minmax_f32_sse2};
+  case RDP_KERNEL_AVX2:
+    return (struct kernel_table){argmax_avx2,     argmax_soa_avx2,
+                                 minmax_avx2,     argmax_f32_avx2,
+                                 argmax_soa_f32_avx2, minmax_f32_avx2};
+  case RDP_KERNEL_AVX512:
+    return (struct kernel_table){argmax_avx512,     argmax_soa_avx512,
+                                 minmax_avx512,     argmax_f32_avx512,
+                                 argmax_soa_f32_avx512, minmax_f32_avx512};
+#endif
+  default:
+    return scalar_table;
+  }
+}
+
+static enum rdp_kernel_isa selected_isa = RDP_KERNEL_SCALAR;
+static struct kernel_table selected = scalar_table;
+
+/*
+ * Runs before main so the selection never races with threads calling the
+ * kernel.
+ */
+__attribute__((constructor)) static void rdp_kernel_select(void) {
+#ifdef RDP_KERNEL_X86
+  __builtin_cpu_init();
+#endif
+  for (int isa = RDP_KERNEL_AVX512; isa > RDP_KERNEL_SCALAR; isa--) {
+    if (isa_supported((enum rdp_kernel_isa)isa)) {
+      selected_isa = (enum rdp_kernel_isa)isa;
+      selected = isa_table(selected_isa);
+      return;
+    }
+  }
+}
+
+int rdp_kernel_argmax(double const *xy, int first, int last,
+                      struct rdp_segment const *seg, double *metric) {
+  if (first >= last)
+    return -1;
+  if (seg->len2 == 0)
+    return argmax_degenerate(xy, first, last, seg, metric);
+  return selected.argmax(xy, first, last, seg, metric);
+}
+
+int rdp_kernel_argmax_soa(double const *xs, double const *ys, int first,
+                          int last, struct rdp_segment const *seg,
+                          double *metric) {
+  if (first >= last)
+    return -1;
+  if (seg->len2 == 0)
+    return argmax_soa_degenerate(xs, ys, first, last, seg, metric);
+  return selected.argmax_soa(xs, ys, first, last, seg, metric);
+}
+
+void rdp_kernel_minmax(double const *values, int length, double *min,
+                       double *max) {
+  if (length <= 0)
+    return;
+  selected.minmax(values, length, min, max);
+}
+
+int rdp_kernel_argmax_f32(float const *xy, int first, int last,
+                          struct rdp_segment const *seg, double *metric) {
+  if (first >= last)
+    return -1;
+  if (seg->len2 == 0)
+    return argmax_f32_degenerate(xy, first, last, seg, metric);
+  return selected.argmax_f32(xy, first, last, seg, metric);
+}
+
+int rdp_kernel_argmax_soa_f32(float const *xs, float const *ys, int first,
+                              int last, struct rdp_segment const *seg,
+                              double *metric) {
+  if (first >= last)
+    return -1;
+  if (seg->len2 == 0)
+    return argmax_soa_f32_degenerate(xs, ys, first, last, seg, metric);
+  return selected.argmax_soa_f32(xs, ys, first, last, seg, metric);
+}
+
+void rdp_kernel_minmax_f32(float const *values, int length, float *min,
+                           float *max) {
+  if (length <= 0)
+    return;
+  selected.minmax_f32(values, length, min, max);
+}
+
+enum rdp_kernel_isa rdp_kernel_get_isa(void) { return selected_isa; }
+
+bool rdp_kernel_set_isa(enum rdp_kernel_isa isa) {
+  if (!isa_supported(isa))
+    return false;
+  selected_isa = isa;
+  selected = isa_table(isa);
+  return true;
+}
+
+char const *rdp_kernel_isa_name(enum rdp_kernel_isa isa) {
+  switch (isa) {
+  case RDP_KERNEL_SCALAR:
+    return "scalar";
+  case RDP_KERNEL_SSE2:
+    return "sse2";
+  case RDP_KERNEL_AVX2:
+    return "avx2";
+  case RDP_KERNEL_AVX512:
+    return "avx512";
+  }
+  return "unknown";
+}
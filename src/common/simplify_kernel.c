@@ -0,0 +1,364 @@
+#include "simplify_kernel.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Every kernel is written once as an always inlined body that reads its
+ * coordinates through coord. The double and float entry points, and two
+ * coordinates against any other number, each get their own copy with the
+ * type and dimension known, so the generic code costs nothing.
+ */
+
+#define SIMPLIFY_INLINE static inline __attribute__((always_inline))
+
+void simplify_workspace_init(struct simplify_workspace *ws) {
+  ws->indices = NULL;
+  ws->length = 0;
+  ws->indices_capacity = 0;
+  ws->links = NULL;
+  ws->heap = NULL;
+  ws->heap_capacity = 0;
+}
+
+void simplify_workspace_free(struct simplify_workspace *ws) {
+  free(ws->indices);
+  free(ws->links);
+  free(ws->heap);
+  simplify_workspace_init(ws);
+}
+
+static void out_of_memory(void) {
+  fprintf(stderr, "Out of memory!");
+  abort();
+}
+
+/*
+ * Appends _index_ to the kept points of _ws_, growing them geometrically
+ */
+static void push_index(struct simplify_workspace *ws, int index) {
+  if (ws->length == ws->indices_capacity) {
+    int capacity = ws->indices_capacity < 16 ? 16 : 2 * ws->indices_capacity;
+    int *grown = realloc(ws->indices, sizeof(*grown) * (size_t)capacity);
+    if (grown == NULL)
+      out_of_memory();
+    ws->indices = grown;
+    ws->indices_capacity = capacity;
+  }
+  ws->indices[ws->length++] = index;
+}
+
+SIMPLIFY_INLINE double coord(void const *coords, bool f32, size_t i) {
+  return f32 ? (double)((float const *)coords)[i]
+             : ((double const *)coords)[i];
+}
+
+/*
+ * The squared distance between points _a_ and _b_
+ */
+SIMPLIFY_INLINE double distance2(void const *coords, bool f32, int dimension,
+                                 int a, int b) {
+  double d2 = 0;
+  for (int k = 0; k < dimension; k++) {
+    double d = coord(coords, f32, (size_t)b * dimension + k) -
+               coord(coords, f32, (size_t)a * dimension + k);
+    d2 += d * d;
+  }
+  return d2;
+}
+
+/*
+ * Twice the area of the triangle made by points _a_, _b_ and _c_. For more
+ * than two coordinates this is |ab| |ac| sin(angle) from the Lagrange
+ * identity.
+ */
+SIMPLIFY_INLINE double area2(void const *coords, bool f32, int dimension,
+                             int a, int b, int c) {
+  size_t pa = (size_t)a * dimension, pb = (size_t)b * dimension,
+         pc = (size_t)c * dimension;
+  if (dimension == 2) {
+    double ax = coord(coords, f32, pa), ay = coord(coords, f32, pa + 1);
+    double cross = (coord(coords, f32, pb) - ax) *
+                       (coord(coords, f32, pc + 1) - ay) -
+                   (coord(coords, f32, pb + 1) - ay) *
+                       (coord(coords, f32, pc) - ax);
+    return fabs(cross);
+  }
+
+  double uu = 0, vv = 0, uv = 0;
+  for (int k = 0; k < dimension; k++) {
+    double u = coord(coords, f32, pb + k) - coord(coords, f32, pa + k);
+    double v = coord(coords, f32, pc + k) - coord(coords, f32, pa + k);
+    uu += u * u;
+    vv += v * v;
+    uv += u * v;
+  }
+  double w = uu * vv - uv * uv;
+  return sqrt(w > 0 ? w : 0);
+}
+
+SIMPLIFY_INLINE void radial_distance(void const *coords, bool f32,
+                                     int dimension, int length,
+                                     double tolerance,
+                                     struct simplify_workspace *ws) {
+  ws->length = 0;
+  if (length == 0)
+    return;
+
+  double limit = tolerance * tolerance;
+  push_index(ws, 0);
+  int key = 0;
+  for (int i = 1; i + 1 < length; i++) {
+    if (distance2(coords, f32, dimension, key, i) >= limit) {
+      push_index(ws, i);
+      key = i;
+    }
+  }
+  if (length > 1)
+    push_index(ws, length - 1);
+}
+
+void simplify_kernel_radial_distance(double const *coords, int dimension,
+                                     int length, double tolerance,
+                                     struct simplify_workspace *ws) {
+  if (dimension == 2)
+    radial_distance(coords, false, 2, length, tolerance, ws);
+  else
+    radial_distance(coords, false, dimension, length, tolerance, ws);
+}
+
+void simplify_kernel_radial_distance_f32(float const *coords, int dimension,
+                                         int length, double tolerance,
+                                         struct simplify_workspace *ws) {
+  if (dimension == 2)
+    radial_distance(coords, true, 2, length, tolerance, ws);
+  else
+    radial_distance(coords, true, dimension, length, tolerance, ws);
+}
+
+SIMPLIFY_INLINE void reumann_witkam(void const *coords, bool f32,
+                                    int dimension, int length,
+                                    double tolerance,
+                                    struct simplify_workspace *ws) {
+  ws->length = 0;
+  if (length == 0)
+    return;
+
+  double half = tolerance / 2;
+  push_index(ws, 0);
+  int key = 0;
+  // the point giving the direction of the strip, -1 until one differs from
+  // the key, and how far along the strip the run has got scaled by its
+  // length
+  int ahead = -1;
+  double width = 0, along = 0;
+  for (int i = 1; i < length; i++) {
+    if (ahead < 0) {
+      double d2 = distance2(coords, f32, dimension, key, i);
+      // points equal to the key are on every line through it
+      if (d2 == 0)
+        continue;
+      ahead = i;
+      width = half * sqrt(d2);
+      along = d2;
+      continue;
+    }
+
+    double s = 0;
+    for (int k = 0; k < dimension; k++) {
+      double origin = coord(coords, f32, (size_t)key * dimension + k);
+      s += (coord(coords, f32, (size_t)i * dimension + k) - origin) *
+           (coord(coords, f32, (size_t)ahead * dimension + k) - origin);
+    }
+    // twice the area of key, ahead, i is the distance from the line times
+    // its length
+    if (s >= along && area2(coords, f32, dimension, key, ahead, i) < width) {
+      along = s;
+      continue;
+    }
+
+    key = i - 1;
+    push_index(ws, key);
+    double a2 = distance2(coords, f32, dimension, key, i);
+    ahead = a2 == 0 ? -1 : i;
+    width = half * sqrt(a2);
+    along = a2;
+  }
+  // the last point is checked like the others so its run keeps the bound
+  if (ws->indices[ws->length - 1] != length - 1)
+    push_index(ws, length - 1);
+}
+
+void simplify_kernel_reumann_witkam(double const *coords, int dimension,
+                                    int length, double tolerance,
+                                    struct simplify_workspace *ws) {
+  if (dimension == 2)
+    reumann_witkam(coords, false, 2, length, tolerance, ws);
+  else
+    reumann_witkam(coords, false, dimension, length, tolerance, ws);
+}
+
+void simplify_kernel_reumann_witkam_f32(float const *coords, int dimension,
+                                        int length, double tolerance,
+                                        struct simplify_workspace *ws) {
+  if (dimension == 2)
+    reumann_witkam(coords, true, 2, length, tolerance, ws);
+  else
+    reumann_witkam(coords, true, dimension, length, tolerance, ws);
+}
+
+/*
+ * The Visvalingam-Whyatt heap, ordered by area and then by index, and where
+ * each point is in it
+ */
+struct heap {
+  struct simplify_heap_entry *entries;
+  int *pos;
+  int size;
+};
+
+/*
+ * Areas are often clamped to the same value, so the tie on the index is
+ * evaluated without a branch that would often be mispredicted
+ */
+SIMPLIFY_INLINE bool heap_before(struct simplify_heap_entry a,
+                                 struct simplify_heap_entry b) {
+  return (a.area < b.area) | ((a.area == b.area) & (a.index < b.index));
+}
+
+SIMPLIFY_INLINE void heap_sift_up(struct heap h, int k) {
+  struct simplify_heap_entry e = h.entries[k];
+  while (k > 0) {
+    int parent = (k - 1) / 2;
+    if (!heap_before(e, h.entries[parent]))
+      break;
+    struct simplify_heap_entry moved = h.entries[parent];
+    h.entries[k] = moved;
+    h.pos[moved.index] = k;
+    k = parent;
+  }
+  h.entries[k] = e;
+  h.pos[e.index] = k;
+}
+
+SIMPLIFY_INLINE void heap_sift_down(struct heap h, int k) {
+  struct simplify_heap_entry e = h.entries[k];
+  while (true) {
+    int child = 2 * k + 1;
+    if (child >= h.size)
+      break;
+    if (child + 1 < h.size && heap_before(h.entries[child + 1], h.entries[child]))
+      child++;
+    if (!heap_before(h.entries[child], e))
+      break;
+    struct simplify_heap_entry moved = h.entries[child];
+    h.entries[k] = moved;
+    h.pos[moved.index] = k;
+    k = child;
+  }
+  h.entries[k] = e;
+  h.pos[e.index] = k;
+}
+
+SIMPLIFY_INLINE void heap_update(struct heap h, int i, double area) {
+  int k = h.pos[i];
+  double old = h.entries[k].area;
+  h.entries[k].area = area;
+  if (area < old)
+    heap_sift_up(h, k);
+  else
+    heap_sift_down(h, k);
+}
+
+/*
+ * Makes room in the links and heap of _ws_ for _length_ points. Both are
+ * allocated once per call at most, so removing a point never allocates.
+ */
+static void reserve_heap(struct simplify_workspace *ws, int length) {
+  if (length <= ws->heap_capacity)
+    return;
+  free(ws->links);
+  free(ws->heap);
+  ws->links = malloc(3 * sizeof(*ws->links) * (size_t)length);
+  ws->heap = malloc(sizeof(*ws->heap) * (size_t)length);
+  if (ws->links == NULL || ws->heap == NULL)
+    out_of_memory();
+  ws->heap_capacity = length;
+}
+
+SIMPLIFY_INLINE double visvalingam(void const *coords, bool f32,
+                                   int dimension, int length, double area,
+                                   int count, struct simplify_workspace *ws) {
+  ws->length = 0;
+  if (length == 0)
+    return 0;
+
+  reserve_heap(ws, length);
+  int *prev = ws->links, *next = prev + length;
+  struct heap h = {ws->heap, next + length, 0};
+  for (int i = 0; i < length; i++) {
+    prev[i] = i - 1;
+    next[i] = i + 1;
+  }
+  for (int i = 1; i + 1 < length; i++) {
+    h.entries[h.size].area = area2(coords, f32, dimension, i - 1, i, i + 1);
+    h.entries[h.size].index = i;
+    h.pos[i] = h.size++;
+  }
+  for (int k = h.size / 2 - 1; k >= 0; k--)
+    heap_sift_down(h, k);
+
+  double limit = 2 * area;
+  double removed = 0;
+  int remaining = length;
+  while (h.size > 0) {
+    struct simplify_heap_entry top = h.entries[0];
+    if (!(top.area < limit) && remaining <= count)
+      break;
+
+    int i = top.index;
+    int before = prev[i], after = next[i];
+    h.size--;
+    if (h.size > 0) {
+      struct simplify_heap_entry last = h.entries[h.size];
+      h.entries[0] = last;
+      h.pos[last.index] = 0;
+      heap_sift_down(h, 0);
+    }
+    next[before] = after;
+    prev[after] = before;
+    remaining--;
+    removed = top.area > removed ? top.area : removed;
+
+    if (before > 0) {
+      double a = area2(coords, f32, dimension, prev[before], before, after);
+      heap_update(h, before, a > removed ? a : removed);
+    }
+    if (after < length - 1) {
+      double a = area2(coords, f32, dimension, before, after, next[after]);
+      heap_update(h, after, a > removed ? a : removed);
+    }
+  }
+
+  for (int i = 0; i < length; i = next[i])
+    push_index(ws, i);
+  return removed / 2;
+}
+
+double simplify_kernel_visvalingam(double const *coords, int dimension,
+                                   int length, double area, int count,
+                                   struct simplify_workspace *ws) {
+  if (dimension == 2)
+    return visvalingam(coords, false, 2, length, area, count, ws);
+  return visvalingam(coords, false, dimension, length, area, count, ws);
+}
+
+double simplify_kernel_visvalingam_f32(float const *coords, int dimension,
+                                       int length, double area, int count,
+                                       struct simplify_workspace *ws) {
+  if (dimension == 2)
+    return visvalingam(coords, true, 2, length, area, count, ws);
+  return visvalingam(coords, true, dimension, length, area, count, ws);
+}
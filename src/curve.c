@@ -1,7 +1,89 @@
 #include "curve.h"
+#include "rdp_kernel.h"
+#include "simplify_kernel.h"
 #include <assert.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int parallel_scan_threads = 1;
+static int parallel_scan_min_length = 1 << 20;
+
+void rdp_set_parallel_scan(int threads, int min_length) {
+  parallel_scan_threads = threads < 1 ? 1 : threads;
+  parallel_scan_min_length = min_length;
+}
+
+struct scan_chunk {
+  double const *xy;
+  struct rdp_segment const *seg;
+  int first, last;
+  int index;
+  double metric;
+  pthread_t thread;
+  bool started;
+};
+
+static void *scan_chunk_run(void *arg) {
+  struct scan_chunk *chunk = arg;
+  chunk->index = rdp_kernel_argmax(chunk->xy, chunk->first, chunk->last,
+                                   chunk->seg, &chunk->metric);
+  return NULL;
+}
+
+/*
+ * Scans [first, last) as parallel_scan_threads chunks, each on its own
+ * thread except the first which runs on the caller. The chunks are reduced
+ * in index order keeping the first of equal maxima, which gives the same
+ * answer as one serial scan.
+ */
+static int parallel_argmax(double const *xy, int first, int last,
+                           struct rdp_segment const *seg, double *metric) {
+  int chunks = parallel_scan_threads;
+  int chunkSize = (last - first + chunks - 1) / chunks;
+
+  struct scan_chunk *scan = malloc(sizeof(*scan) * chunks);
+  if (scan == NULL)
+    return rdp_kernel_argmax(xy, first, last, seg, metric);
+
+  for (int c = 0; c < chunks; c++) {
+    scan[c].xy = xy;
+    scan[c].seg = seg;
+    scan[c].first = first + c * chunkSize;
+    scan[c].last = scan[c].first + chunkSize < last ? scan[c].first + chunkSize
+                                                    : last;
+  }
+
+  // chunks that fail to start a thread are scanned on this thread instead
+  for (int c = 1; c < chunks; c++) {
+    scan[c].started =
+        pthread_create(&scan[c].thread, NULL, scan_chunk_run, &scan[c]) == 0;
+  }
+  scan_chunk_run(&scan[0]);
+  for (int c = 1; c < chunks; c++) {
+    if (scan[c].started)
+      pthread_join(scan[c].thread, NULL);
+    else
+      scan_chunk_run(&scan[c]);
+  }
+
+  int furthestIndex = -1;
+  double record = 0;
+  for (int c = 0; c < chunks; c++) {
+    if (scan[c].index != -1 && scan[c].metric > record) {
+      furthestIndex = scan[c].index;
+      record = scan[c].metric;
+    }
+  }
+  if (furthestIndex != -1)
+    *metric = record;
+
+  free(scan);
+  return furthestIndex;
+}
 
 int furthestPoint(curve const *inCurve, int start, int end, double *distance) {
 
@@ -13,40 +95,143 @@ int furthestPoint(curve const *inCurve, int start, int end, double *distance) {
   }
 #endif
 
-  int furthestIndex = -1;
-  double recordDist = 0;
-
-  point *s = &inCurve->points[start];
-  point *e = &inCurve->points[end];
-  for (int i = start + 1; i < end; i++) {
-    double t = p2ldist(&inCurve->points[i], s, e);
-    if (t > recordDist) {
-      furthestIndex = i;
-      recordDist = t;
-      *distance = recordDist;
-    }
-  }
+  point const *s = &inCurve->points[start];
+  point const *e = &inCurve->points[end];
+
+  struct rdp_segment seg;
+  rdp_segment_init(&seg, s->x, s->y, e->x, e->y);
+
+  double const *xy = (double const *)inCurve->points;
+  double metric;
+  int furthestIndex;
+  if (parallel_scan_threads > 1 && end - start - 1 >= parallel_scan_min_length)
+    furthestIndex = parallel_argmax(xy, start + 1, end, &seg, &metric);
+  else
+    furthestIndex = rdp_kernel_argmax(xy, start + 1, end, &seg, &metric);
+
+  if (furthestIndex != -1)
+    *distance = rdp_segment_distance(&seg, metric);
   return furthestIndex;
 }
 
-static void rdp_support(curve const *original, double epsilon, int sidx,
-                        int eidx, int *included, int *totalPoints) {
+/*
+ * Makes sure the buffer pointed to by _data_ can hold _needed_ elements of
+ * _size_ bytes, growing it geometrically. Aborts if out of memory.
+ */
+static void reserve(void **data, int *capacity, int needed, size_t size) {
+  if (needed <= *capacity)
+    return;
+  int newCapacity = *capacity < 16 ? 16 : *capacity;
+  while (newCapacity < needed)
+    newCapacity *= 2;
+  void *grown = realloc(*data, size * newCapacity);
+  if (grown == NULL) {
+    fprintf(stderr, "Out of memory!");
+    abort();
+  }
+  *data = grown;
+  *capacity = newCapacity;
+}
+
+static void push_span(struct rdp_workspace *ws, int *top, int start, int end,
+                      bool emit_start) {
+  reserve((void **)&ws->stack, &ws->stack_capacity, *top + 1,
+          sizeof(*ws->stack));
+  ws->stack[*top].start = start;
+  ws->stack[*top].end = end;
+  ws->stack[*top].emit_start = emit_start;
+  (*top)++;
+}
+
+static void push_index(struct rdp_workspace *ws, int index) {
+  reserve((void **)&ws->indices, &ws->indices_capacity, ws->length + 1,
+          sizeof(*ws->indices));
+  ws->indices[ws->length++] = index;
+}
+
+/*
+ * Fills ws->indices with the indices kept by the Ramer-Douglas-Peuker
+ * algorithm in ascending order. The pending ranges live on an explicit stack
+ * so deep splits cannot overflow the call stack. The left range of a split
+ * is pushed last so it is finished first and the right range outputs the
+ * split point before it is scanned.
+ *
+ * This is always inlined so the callers that pass NULL for _stats_ get a
+ * copy with the counting removed.
+ */
+static inline __attribute__((always_inline)) void
+rdp_support(curve const *original, double epsilon, struct rdp_workspace *ws,
+            struct rdp_stats *stats) {
+  ws->length = 0;
+  if (original->length == 0)
+    return;
 
-  if (sidx >= eidx)
+  push_index(ws, 0);
+  if (original->length == 1)
     return;
 
-  double d;
-  int furthestIdx = furthestPoint(original, sidx, eidx, &d);
-  if (furthestIdx != -1) {
-    if (d < epsilon) {
-      return;
-    } else {
-      included[furthestIdx] = 1;
-      *totalPoints = *totalPoints + 1;
-      rdp_support(original, epsilon, sidx, furthestIdx, included, totalPoints);
-      rdp_support(original, epsilon, furthestIdx, eidx, included, totalPoints);
+  int top = 0;
+  push_span(ws, &top, 0, original->length - 1, false);
+  while (top > 0) {
+    struct rdp_span s = ws->stack[--top];
+
+    if (s.emit_start)
+      push_index(ws, s.start);
+
+    if (s.end - s.start < 2)
+      continue;
+
+    if (stats != NULL) {
+      stats->segments++;
+      stats->distance_evaluations += s.end - s.start - 1;
     }
+
+    double d;
+    int furthestIdx = furthestPoint(original, s.start, s.end, &d);
+    if (furthestIdx == -1 || d < epsilon)
+      continue;
+
+    push_span(ws, &top, furthestIdx, s.end, true);
+    push_span(ws, &top, s.start, furthestIdx, false);
+    if (stats != NULL && top > stats->max_depth)
+      stats->max_depth = top;
   }
+  push_index(ws, original->length - 1);
+}
+
+/*
+ * Copies the points listed in ws->indices into ws->points
+ */
+static curve gather_points(curve const *start, struct rdp_workspace *ws) {
+  reserve((void **)&ws->points, &ws->points_capacity, ws->length,
+          sizeof(*ws->points));
+  for (int i = 0; i < ws->length; i++) {
+    ws->points[i] = start->points[ws->indices[i]];
+  }
+
+  curve result;
+  result.points = ws->points;
+  result.length = ws->length;
+  return result;
+}
+
+/*
+ * Moves the points kept in _ws_ into a curve that rdp_result_free can free
+ * and releases the rest of the workspace
+ */
+static curve *take_result(curve result, struct rdp_workspace *ws) {
+  curve *v = malloc(sizeof(*v));
+  if (v == NULL) {
+    fprintf(stderr, "Out of memory!");
+    abort();
+  }
+  v->points = result.points;
+  v->length = result.length;
+
+  // the points now belong to v
+  ws->points = NULL;
+  rdp_workspace_free(ws);
+  return v;
 }
 
 curve *rdp(curve const *start, double epsilon) {
@@ -58,33 +243,279 @@ curve *rdp(curve const *start, double epsilon) {
   }
 #endif
 
-  int *included = calloc(start->length, sizeof(int));
-  included[0] = 1;
-  included[start->length - 1] = 1;
+  struct rdp_workspace ws;
+  rdp_workspace_init(&ws);
+  return take_result(rdp_with_workspace(start, epsilon, &ws), &ws);
+}
 
-  int totalPoints = 2;
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
 
-  rdp_support(start, epsilon, 0, start->length - 1, included, &totalPoints);
+curve *rdp_with_stats(curve const *start, double epsilon,
+                      struct rdp_stats *stats) {
 
-  point *result = malloc(sizeof(point) * totalPoints);
+#ifdef DEBUG
+  if (start == NULL || stats == NULL) {
+    fprintf(stderr, "Do not pass null to rdp_with_stats()\n");
+    abort();
+  }
+#endif
 
-  int resultIdx = 0;
-  for (int i = 0; i < start->length; i++) {
-    if (included[i]) {
-      assert(resultIdx < totalPoints);
-      result[resultIdx].x = start->points[i].x;
-      result[resultIdx].y = start->points[i].y;
-      resultIdx++;
-    }
+  memset(stats, 0, sizeof(*stats));
+  struct rdp_workspace ws;
+  rdp_workspace_init(&ws);
+
+  uint64_t begin = now_ns();
+  rdp_support(start, epsilon, &ws, stats);
+  uint64_t split = now_ns();
+  curve result = gather_points(start, &ws);
+  uint64_t end = now_ns();
+
+  stats->kept = ws.length;
+  stats->split_ns = split - begin;
+  stats->gather_ns = end - split;
+  stats->bytes_allocated = ws.stack_capacity * sizeof(*ws.stack) +
+                           ws.indices_capacity * sizeof(*ws.indices) +
+                           ws.points_capacity * sizeof(*ws.points);
+  return take_result(result, &ws);
+}
+
+void rdp_workspace_init(struct rdp_workspace *ws) {
+  ws->stack = NULL;
+  ws->stack_capacity = 0;
+  ws->indices = NULL;
+  ws->indices_capacity = 0;
+  ws->length = 0;
+  ws->points = NULL;
+  ws->points_capacity = 0;
+}
+
+void rdp_workspace_free(struct rdp_workspace *ws) {
+  free(ws->stack);
+  free(ws->indices);
+  free(ws->points);
+  rdp_workspace_init(ws);
+}
+
+int rdp_indices(curve const *start, double epsilon, struct rdp_workspace *ws) {
+
+#ifdef DEBUG
+  if (start == NULL || ws == NULL) {
+    fprintf(stderr, "Do not pass null to rdp_indices()\n");
+    abort();
   }
+#endif
 
-  free(included);
+  rdp_support(start, epsilon, ws, NULL);
+  return ws->length;
+}
 
-  curve *v = malloc(sizeof(*v));
-  v->points = result;
-  v->length = totalPoints;
+curve rdp_with_workspace(curve const *start, double epsilon,
+                         struct rdp_workspace *ws) {
 
-  return v;
+#ifdef DEBUG
+  if (start == NULL || ws == NULL) {
+    fprintf(stderr, "Do not pass null to rdp_with_workspace()\n");
+    abort();
+  }
+#endif
+
+  rdp_indices(start, epsilon, ws);
+  return gather_points(start, ws);
+}
+
+int rdp_mask(curve const *start, double epsilon, uint64_t *mask,
+             struct rdp_workspace *ws) {
+
+#ifdef DEBUG
+  if (start == NULL || mask == NULL || ws == NULL) {
+    fprintf(stderr, "Do not pass null to rdp_mask()\n");
+    abort();
+  }
+#endif
+
+  rdp_indices(start, epsilon, ws);
+
+  memset(mask, 0, RDP_MASK_WORDS(start->length) * sizeof(*mask));
+  for (int i = 0; i < ws->length; i++) {
+    int k = ws->indices[i];
+    mask[k / 64] |= UINT64_C(1) << (k % 64);
+  }
+  return ws->length;
+}
+
+struct curve_view rdp_view(curve const *start, double epsilon,
+                           struct rdp_workspace *ws) {
+
+#ifdef DEBUG
+  if (start == NULL || ws == NULL) {
+    fprintf(stderr, "Do not pass null to rdp_view()\n");
+    abort();
+  }
+#endif
+
+  rdp_indices(start, epsilon, ws);
+
+  struct curve_view view;
+  view.source = start;
+  view.indices = ws->indices;
+  view.length = ws->length;
+  return view;
+}
+
+/*
+ * Makes the indices kept by a simplify kernel those of _ws_ and releases the
+ * rest of _kernel_
+ */
+static void take_kept(struct simplify_workspace *kernel,
+                      struct rdp_workspace *ws) {
+  rdp_workspace_init(ws);
+  ws->indices = kernel->indices;
+  ws->length = kernel->length;
+  ws->indices_capacity = kernel->indices_capacity;
+
+  // the indices now belong to ws
+  kernel->indices = NULL;
+  simplify_workspace_free(kernel);
+}
+
+curve *visvalingam(curve const *start, double area) {
+
+#ifdef DEBUG
+  if (start == NULL) {
+    fprintf(stderr, "Do not pass null to visvalingam()\n");
+    abort();
+  }
+#endif
+
+  struct simplify_workspace kernel;
+  struct rdp_workspace ws;
+  simplify_workspace_init(&kernel);
+  simplify_kernel_visvalingam((double const *)start->points, 2, start->length,
+                              area, start->length, &kernel);
+  take_kept(&kernel, &ws);
+  return take_result(gather_points(start, &ws), &ws);
+}
+
+curve *visvalingam_to_count(curve const *start, int count, double *area) {
+
+#ifdef DEBUG
+  if (start == NULL) {
+    fprintf(stderr, "Do not pass null to visvalingam_to_count()\n");
+    abort();
+  }
+#endif
+
+  struct simplify_workspace kernel;
+  struct rdp_workspace ws;
+  simplify_workspace_init(&kernel);
+  double removed = simplify_kernel_visvalingam(
+      (double const *)start->points, 2, start->length, 0, count, &kernel);
+  if (area != NULL)
+    *area = removed;
+  take_kept(&kernel, &ws);
+  return take_result(gather_points(start, &ws), &ws);
+}
+
+curve *radial_distance(curve const *start, double tolerance) {
+
+#ifdef DEBUG
+  if (start == NULL) {
+    fprintf(stderr, "Do not pass null to radial_distance()\n");
+    abort();
+  }
+#endif
+
+  struct simplify_workspace kernel;
+  struct rdp_workspace ws;
+  simplify_workspace_init(&kernel);
+  simplify_kernel_radial_distance((double const *)start->points, 2,
+                                  start->length, tolerance, &kernel);
+  take_kept(&kernel, &ws);
+  return take_result(gather_points(start, &ws), &ws);
+}
+
+curve *reumann_witkam(curve const *start, double tolerance) {
+
+#ifdef DEBUG
+  if (start == NULL) {
+    fprintf(stderr, "Do not pass null to reumann_witkam()\n");
+    abort();
+  }
+#endif
+
+  struct simplify_workspace kernel;
+  struct rdp_workspace ws;
+  simplify_workspace_init(&kernel);
+  simplify_kernel_reumann_witkam((double const *)start->points, 2,
+                                 start->length, tolerance, &kernel);
+  take_kept(&kernel, &ws);
+  return take_result(gather_points(start, &ws), &ws);
+}
+
+curve *rdp_prefiltered(curve const *start, double epsilon, double tolerance) {
+
+#ifdef DEBUG
+  if (start == NULL) {
+    fprintf(stderr, "Do not pass null to rdp_prefiltered()\n");
+    abort();
+  }
+#endif
+
+  if (!(tolerance >= 0 && tolerance < epsilon))
+    return NULL;
+
+  struct simplify_workspace kernel;
+  struct rdp_workspace filtered, ws;
+  simplify_workspace_init(&kernel);
+  simplify_kernel_reumann_witkam((double const *)start->points, 2,
+                                 start->length, tolerance, &kernel);
+  take_kept(&kernel, &filtered);
+  curve reduced = gather_points(start, &filtered);
+  rdp_workspace_init(&ws);
+  rdp_indices(&reduced, epsilon - tolerance, &ws);
+
+  // map the indices into the reduced curve back to _start_
+  for (int i = 0; i < ws.length; i++)
+    ws.indices[i] = filtered.indices[ws.indices[i]];
+  rdp_workspace_free(&filtered);
+  return take_result(gather_points(start, &ws), &ws);
+}
+
+bool curve_from_file_map(struct curve_file_map const *map, curve *out) {
+
+#ifdef DEBUG
+  if (map == NULL || out == NULL) {
+    fprintf(stderr, "Do not pass null to curve_from_file_map()\n");
+    abort();
+  }
+#endif
+
+  struct curve_file_header const *header = map->header;
+  if (header->type != CURVE_FILE_FLOAT64 || header->dimension != 2 ||
+      header->layout != CURVE_FILE_INTERLEAVED || header->count > INT_MAX)
+    return false;
+
+  out->points = map->data;
+  out->length = (int)header->count;
+  return true;
+}
+
+bool curve_write_file(char const *path, curve const *c) {
+
+#ifdef DEBUG
+  if (path == NULL || c == NULL) {
+    fprintf(stderr, "Do not pass null to curve_write_file()\n");
+    abort();
+  }
+#endif
+
+  void const *coords[] = {c->points};
+  return curve_file_write(path, CURVE_FILE_FLOAT64, 2, CURVE_FILE_INTERLEAVED,
+                          (uint64_t)c->length, coords);
 }
 
 void rdp_result_free(curve *c) {
@@ -101,100 +532,308 @@ void curve_linear_free(curve *c) {
   free(c);
 }
 
-static double quadratic(double a, double b, double c, double x) {
-  return a * pow(x, 2) + b * c + c;
+static int construct_threads = 1;
+static int construct_min_length = 1 << 20;
+
+void curve_set_parallel_construct(int threads, int min_length) {
+  construct_threads = threads < 1 ? 1 : threads;
+  construct_min_length = min_length;
+}
+
+/*
+ * The _i_th of _count_ samples from _start_ to _end_. Each one is computed
+ * from _start_ so no error builds up, and the last one is exactly _end_.
+ */
+static double sample_at(double start, double end, double delta, int count,
+                        int i) {
+  return i == count - 1 ? end : start + i * delta;
 }
 
+/*
+ * The number of samples from _start_ to _end_ at most _delta_ apart: every
+ * start + i * delta below _end_, then _end_ itself. Returns -1 if _delta_ is
+ * not positive or there would be more than INT_MAX samples.
+ */
 static int count_between(double start, double end, double delta) {
-  double c = fabs(end - start) / delta;
-  int q = (int)c;
-  double difference = c - q;
-  printf("c is %d difference is %f and q is %d\n", (int)c, difference, q);
-  return ((int)c + 1) + (fabs(difference) != 0);
+  if (!(delta > 0))
+    return -1;
+  if (!(end > start))
+    return 1;
+
+  double estimate = ceil((end - start) / delta);
+  if (!(estimate < INT_MAX))
+    return -1;
+
+  /* the estimate can be off by one either way after rounding */
+  long k = (long)estimate;
+  while (k > 0 && !(start + (k - 1) * delta < end))
+    k--;
+  while (start + k * delta < end)
+    k++;
+  return k < INT_MAX ? (int)k + 1 : -1;
 }
 
-curve *curve_from_quadratic(double a, double b, double c, double xstart,
-                            double xend, double delta) {
+/* what y is computed from for every point of a curve being built */
+struct curve_function {
+  double (*f)(double, void const *);
+  void const *context;
+};
+
+struct construct_chunk {
+  point *points;
+  double start, end, delta;
+  int count, first, last;
+  struct curve_function const *f;
+  pthread_t thread;
+  bool started;
+};
+
+static void *construct_chunk_run(void *arg) {
+  struct construct_chunk *chunk = arg;
+  for (int i = chunk->first; i < chunk->last; i++) {
+    double x =
+        sample_at(chunk->start, chunk->end, chunk->delta, chunk->count, i);
+    chunk->points[i].x = x;
+    chunk->points[i].y = chunk->f->f(x, chunk->f->context);
+  }
+  return NULL;
+}
+
+/*
+ * Samples _f_ from _start_ to _end_ at most _delta_ apart into a curve
+ * allocated once. Curves of at least construct_min_length points are split
+ * into construct_threads chunks that are evaluated on their own threads.
+ */
+static curve *sample_curve(double start, double end, double delta,
+                           struct curve_function const *f) {
+  int count = count_between(start, end, delta);
+  if (count < 0)
+    return NULL;
+
   curve *result = malloc(sizeof(*result));
-  int count = count_between(xstart, xend, delta) + 1;
-  printf("count is %d\n", count);
-  result->points = malloc(sizeof(point) * count);
+  if (result != NULL)
+    result->points = malloc(sizeof(*result->points) * count);
+  if (result == NULL || result->points == NULL) {
+    fprintf(stderr, "Out of memory!");
+    abort();
+  }
   result->length = count;
-  int index = 0;
-  for (double x = xstart; x < xend; x += delta) {
-    result->points[index].x = x;
-    result->points[index++].y = quadratic(a, b, c, x);
-  }
-  result->points[result->length - 1].x = xend;
-  result->points[result->length - 1].y = quadratic(a, b, c, xend);
-  result->length++;
+
+  int chunks = count < construct_min_length ? 1 : construct_threads;
+  struct construct_chunk single;
+  struct construct_chunk *chunk = &single;
+  if (chunks > 1)
+    chunk = malloc(sizeof(*chunk) * chunks);
+  if (chunk == NULL) {
+    chunk = &single;
+    chunks = 1;
+  }
+
+  int chunk_size = (count + chunks - 1) / chunks;
+  for (int c = 0; c < chunks; c++) {
+    chunk[c] = (struct construct_chunk){.points = result->points,
+                                        .start = start,
+                                        .end = end,
+                                        .delta = delta,
+                                        .count = count,
+                                        .first = c * chunk_size,
+                                        .last = (c + 1) * chunk_size,
+                                        .f = f};
+    if (chunk[c].last > count)
+      chunk[c].last = count;
+  }
+
+  /* chunks that fail to start a thread run on this thread instead */
+  for (int c = 1; c < chunks; c++) {
+    chunk[c].started = pthread_create(&chunk[c].thread, NULL,
+                                      construct_chunk_run, &chunk[c]) == 0;
+  }
+  construct_chunk_run(&chunk[0]);
+  for (int c = 1; c < chunks; c++) {
+    if (chunk[c].started)
+      pthread_join(chunk[c].thread, NULL);
+    else
+      construct_chunk_run(&chunk[c]);
+  }
+
+  if (chunk != &single)
+    free(chunk);
   return result;
 }
 
-static double linear_eq(double x1, double y1, double slope, double x) {
-  return slope * x - slope * x1 + y1;
+struct quadratic {
+  double a, b, c;
+};
+
+static double quadratic(double x, void const *context) {
+  struct quadratic const *q = context;
+  return q->a * pow(x, 2) + q->b * x + q->c;
+}
+
+curve *curve_from_quadratic(double a, double b, double c, double xstart,
+                            double xend, double delta) {
+  struct quadratic q = {a, b, c};
+  struct curve_function f = {quadratic, &q};
+  return sample_curve(xstart, xend, delta, &f);
+}
+
+struct linear {
+  double x1, y1, slope;
+};
+
+static double linear_eq(double x, void const *context) {
+  struct linear const *l = context;
+  return l->slope * x - l->slope * l->x1 + l->y1;
 }
 
 curve *curve_from_line(double x1, double y1, double x2, double y2,
                        double delta) {
   double slope = (y2 - y1) / (x2 - x1);
+  if (!isinf(slope)) {
+    struct linear l = {x1, y1, slope};
+    struct curve_function f = {linear_eq, &l};
+    return sample_curve(x1, x2, delta, &f);
+  }
+
+  /* vertical lines are sampled along y, walking down if y2 is below y1 */
+  double sign = y2 < y1 ? -1 : 1;
+  int count = count_between(sign * y1, sign * y2, delta);
+  if (count < 0)
+    return NULL;
+
   curve *result = malloc(sizeof(*result));
-  // int count = (int)((fabs(y1 - y2) / delta) + 1);
-  int count = count_between(y2, y1, delta) + 1;
-  result->points = malloc(sizeof(point) * count);
+  if (result != NULL)
+    result->points = malloc(sizeof(*result->points) * count);
+  if (result == NULL || result->points == NULL) {
+    fprintf(stderr, "Out of memory!");
+    abort();
+  }
   result->length = count;
-  int index = 0;
-  if (isinf(slope)) {
-    if (y2 < y1) {
-      for (double start = y1; start > y2; start -= delta) {
-        result->points[index].x = x1;
-        result->points[index++].y = start;
-      }
-      result->points[result->length - 1].x = x2;
-      result->points[result->length - 1].y = linear_eq(x1, y1, slope, x2);
-      result->length++;
-    } else {
-      for (double start = y1; start < y2; start += delta) {
-        result->points[index].x = x1;
-        result->points[index++].y = start;
-      }
-      result->points[result->length - 1].x = x2;
-      result->points[result->length - 1].y = linear_eq(x1, y1, slope, x2);
-      result->length++;
-    }
-  } else {
-    for (double start = x1; start < x2; start += delta) {
-      double y = linear_eq(x1, y1, slope, start);
-      result->points[index].x = start;
-      result->points[index++].y = y;
-    }
-    result->points[result->length - 1].x = x2;
-    result->points[result->length - 1].y = linear_eq(x1, y1, slope, x2);
-    result->length++;
+  for (int i = 0; i < count - 1; i++) {
+    result->points[i].x = x1;
+    result->points[i].y = sign * sample_at(sign * y1, sign * y2, delta, count, i);
   }
+  result->points[count - 1].x = x2;
+  result->points[count - 1].y = y2;
   return result;
 }
 
+static double call_function(double x, void const *context) {
+  double (*const *f)(double) = context;
+  return (*f)(x);
+}
+
 curve *curve_construct(double startX, double endX, double delta,
                        double (*f)(double)) {
-  curve *result = malloc(sizeof(*result));
-  result->length = 0;
-  // int count = (int)((fabs(endX - startX) / delta) + 1);
-  int count = count_between(startX, endX, delta) + 1;
-  result->points = malloc(sizeof(point) * count);
-  int index = 0;
-  while (startX < endX) {
-    result->points[index].x = startX;
-    result->points[index++].y = f(startX);
-    startX += delta;
-    result->length++;
-  }
-  fprintf(stderr, "result length is %d and count is %d\n", result->length,
-          count);
-  // assert((result->length == (count - 1)) || (result->length == (count - 2)));
-  result->points[result->length - 1].x = endX;
-  result->points[result->length - 1].y = f(endX);
-  result->length++;
+  struct curve_function function = {call_function, &f};
+  return sample_curve(startX, endX, delta, &function);
+}
+
+/* a run of samples being refined by curve_adaptive */
+struct adaptive_span {
+  int start, end;
+  point s, e;
+};
+
+static void push_adaptive(struct adaptive_span **stack, int *capacity,
+                          int *top, struct adaptive_span span) {
+  reserve((void **)stack, capacity, *top + 1, sizeof(**stack));
+  (*stack)[(*top)++] = span;
+}
+
+static point sample_point(double start, double end, double delta, int count,
+                          int i, double (*f)(double)) {
+  double x = sample_at(start, end, delta, count, i);
+  return (point){x, f(x)};
+}
+
+/*
+ * Fills _out_ with the first sample and the end of every chord kept when
+ * refining the samples from _start_ to _end_ only where f bends. Each run
+ * is kept if the samples a quarter, half and three quarters of the way
+ * along it are closer than _epsilon_ to its chord and is otherwise split at
+ * the furthest of them.
+ */
+static void adaptive_samples(double start, double end, double delta,
+                             int count, double epsilon, double (*f)(double),
+                             int segments, curve *out) {
+  int capacity = 0, top = 0, stack_capacity = 0;
+  struct adaptive_span *stack = NULL;
+  out->points = NULL;
+  out->length = 0;
+
+  reserve((void **)&out->points, &capacity, 1, sizeof(*out->points));
+  out->points[out->length++] = sample_point(start, end, delta, count, 0, f);
+
+  if (count > 1) {
+    /* the initial runs are pushed right to left so they are refined left
+     * to right and the output comes out in order */
+    int last = count - 1;
+    int runs = segments < 1 ? 1 : segments > last ? last : segments;
+    int run_end = last;
+    point e = sample_point(start, end, delta, count, run_end, f);
+    for (int k = runs - 1; k > 0; k--) {
+      int run_start =
+          k * (last / runs) + (k < last % runs ? k : last % runs);
+      point s = sample_point(start, end, delta, count, run_start, f);
+      push_adaptive(&stack, &stack_capacity, &top,
+                    (struct adaptive_span){run_start, run_end, s, e});
+      run_end = run_start;
+      e = s;
+    }
+    push_adaptive(&stack, &stack_capacity, &top,
+                  (struct adaptive_span){0, run_end, out->points[0], e});
+  }
+
+  while (top > 0) {
+    struct adaptive_span p = stack[--top];
+
+    int span = p.end - p.start;
+    if (span >= 2) {
+      point probes[3];
+      int indices[3];
+      int n = 0;
+      for (int q = 1; q <= 3; q++) {
+        int i = p.start + (int)((long)span * q / 4);
+        if (i > p.start && (n == 0 || i != indices[n - 1])) {
+          indices[n] = i;
+          probes[n++] = sample_point(start, end, delta, count, i, f);
+        }
+      }
+
+      struct rdp_segment seg;
+      rdp_segment_init(&seg, p.s.x, p.s.y, p.e.x, p.e.y);
+      double metric;
+      int j = rdp_kernel_argmax((double const *)probes, 0, n, &seg, &metric);
+      if (j != -1 && !(rdp_segment_distance(&seg, metric) < epsilon)) {
+        /* the left half is pushed last so it is finished first */
+        push_adaptive(&stack, &stack_capacity, &top,
+                      (struct adaptive_span){indices[j], p.end, probes[j],
+                                             p.e});
+        push_adaptive(&stack, &stack_capacity, &top,
+                      (struct adaptive_span){p.start, indices[j], p.s,
+                                             probes[j]});
+        continue;
+      }
+    }
+    reserve((void **)&out->points, &capacity, out->length + 1,
+            sizeof(*out->points));
+    out->points[out->length++] = p.e;
+  }
+  free(stack);
+}
+
+curve *curve_adaptive(double startX, double endX, double delta,
+                      double epsilon, double (*f)(double), int segments) {
+  int count = count_between(startX, endX, delta);
+  if (count < 0)
+    return NULL;
+
+  curve sampled;
+  adaptive_samples(startX, endX, delta, count, epsilon / 2, f, segments,
+                   &sampled);
+  curve *result = rdp(&sampled, epsilon / 2);
+  free(sampled.points);
   return result;
 }
 
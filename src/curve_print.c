@@ -38,7 +38,7 @@ bool get_term_size(int *h, int *w) {
 
   int termwidth = (int)(strtol(ctermwidth, &end, 10));
 
-  if (end == ctermheight)
+  if (end == ctermwidth)
     return false;
 
   *h = termheight;
@@ -58,24 +58,16 @@ bool get_curve_extrema(curve const *c, struct curve_extrema *result) {
   if (c->length == 0)
     return false;
 
-  point *points = c->points;
-
   double xmin = c->points[0].x;
   double xmax = c->points[0].x;
   double ymin = c->points[0].y;
   double ymax = c->points[0].y;
   for (int i = 1; i < c->length; i++) {
-    if (c->points[i].x > xmax)
-      xmax = c->points[i].x;
-
-    if (c->points[i].x < xmin)
-      xmin = c->points[i].x;
-
-    if (c->points[i].y > ymax)
-      ymax = c->points[i].y;
-
-    if (c->points[i].y < ymin)
-      ymin = c->points[i].y;
+    double x = c->points[i].x, y = c->points[i].y;
+    xmin = x < xmin ? x : xmin;
+    xmax = x > xmax ? x : xmax;
+    ymin = y < ymin ? y : ymin;
+    ymax = y > ymax ? y : ymax;
   }
 
   result->xmax = xmax;
@@ -103,41 +95,62 @@ void fix_bounds(double *min, double *max, bool sym, bool start0) {
   }
 }
 
-struct screen {
-  int height, width;
-  char **data;
-};
-
-static struct screen make_screen(int theight, int twidth) {
-  char **data = malloc(sizeof(char *) * theight);
-
-  if (data == NULL) {
-    fprintf(stderr, "Out of memory!");
-    abort();
-  }
-
-  for (int i = 0; i < theight; i++) {
-    data[i] = malloc(sizeof(char) * twidth);
-    if (data[i] == NULL) {
+/*
+ * The last frame drawn, height rows of width cells each ending in a
+ * newline. It is kept between calls so printing does not allocate once it
+ * has grown to the terminal size, which also means curve_print must not be
+ * called from two threads at once.
+ */
+static char *frame;
+static size_t frame_capacity;
+
+static void clear_frame(int height, int width) {
+  size_t stride = (size_t)width + 1;
+  size_t size = stride * height;
+  if (size > frame_capacity) {
+    char *grown = realloc(frame, size);
+    if (grown == NULL) {
       fprintf(stderr, "Out of memory!");
-      free(data);
       abort();
     }
-    memset(data[i], '-', twidth);
+    frame = grown;
+    frame_capacity = size;
   }
 
-  struct screen s;
-  s.data = data;
-  s.height = theight;
-  s.width = twidth;
-  return s;
+  memset(frame, '-', size);
+  for (int row = 0; row < height; row++)
+    frame[row * stride + width] = '\n';
 }
 
-static void free_screen(struct screen s) {
-  for (int i = 0; i < s.height; i++) {
-    free(s.data[i]);
+/*
+ * Marks the cells of the frame on the line from cell (_x0_, _y0_) to cell
+ * (_x1_, _y1_), counting rows from the bottom
+ */
+static void draw_line(int height, int width, int x0, int y0, int x1,
+                      int y1) {
+  size_t stride = (size_t)width + 1;
+  int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+  while (true) {
+    frame[(height - 1 - y0) * stride + x0] = 'X';
+    if (x0 == x1 && y0 == y1)
+      return;
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
   }
-  free(s.data);
+}
+
+static int clamp_cell(double v, int size) {
+  int cell = (int)v;
+  return cell < 0 ? 0 : cell >= size ? size - 1 : cell;
 }
 
 void curve_print(curve const *c, struct curve_print_properties *prop) {
@@ -166,25 +179,31 @@ void curve_print(curve const *c, struct curve_print_properties *prop) {
   fix_bounds(&e.ymin, &e.ymax, ysym, y0);
 
   int theight, twidth;
-  if (!get_term_size(&theight, &twidth)) {
+  if (!get_term_size(&theight, &twidth) || theight <= 0 || twidth <= 0) {
     return;
   }
 
-  struct screen s = make_screen(theight, twidth);
+  clear_frame(theight, twidth);
 
-  for (int i = 0; i < c->length; i++) {
-    point const *p = &c->points[i];
-    int xchar = (int)map(p->x, e.xmin, e.xmax, 0.0, twidth - 1.0);
-    int ychar = (int)map(p->y, e.ymin, e.ymax, 0.0, theight - 1.0);
-    s.data[theight - ((int)ychar) - 1][(int)xchar] = 'X';
-  }
-
-  for (int i = 0; i < theight; i++) {
-    for (int j = 0; j < twidth; j++) {
-      putchar(s.data[i][j]);
-    }
-    putchar('\n');
+  /* points are placed with map() as before, dividing before scaling so the
+   * largest values land exactly in the last cell. Points landing in the same
+   * cell as the one before them are skipped */
+  int px = clamp_cell(map(c->points[0].x, e.xmin, e.xmax, 0, twidth - 1.0),
+                      twidth);
+  int py = clamp_cell(map(c->points[0].y, e.ymin, e.ymax, 0, theight - 1.0),
+                      theight);
+  draw_line(theight, twidth, px, py, px, py);
+  for (int i = 1; i < c->length; i++) {
+    int x = clamp_cell(map(c->points[i].x, e.xmin, e.xmax, 0, twidth - 1.0),
+                       twidth);
+    int y = clamp_cell(map(c->points[i].y, e.ymin, e.ymax, 0, theight - 1.0),
+                       theight);
+    if (x == px && y == py)
+      continue;
+    draw_line(theight, twidth, px, py, x, y);
+    px = x;
+    py = y;
   }
 
-  free_screen(s);
+  fwrite(frame, 1, ((size_t)twidth + 1) * theight, stdout);
 }
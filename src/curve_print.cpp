@@ -1,4 +1,10 @@
 #include "curve_print.hpp"
+#include <charconv>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
 
 curve_print::curve_print(bool startX0, bool startY0, bool symmetricX,
                          bool symmetricY, int twidth, int theight,
@@ -33,3 +39,99 @@ curve_print::curve_print(bool startX0, bool startY0, bool symmetricX,
   curve_print::theight = termheight;
   curve_print::twidth = termwidth;
 }
+
+void curve_print::clear_frame() const {
+  if (twidth < 0 || theight < 0) {
+    frame_.clear();
+    return;
+  }
+  int stride = twidth + 1;
+  frame_.assign(static_cast<std::size_t>(stride) * theight, '-');
+  for (int row = 0; row < theight; row++)
+    frame_[static_cast<std::size_t>(row) * stride + twidth] = '\n';
+}
+
+void curve_print::draw_line(int x0, int y0, int x1, int y1) const {
+  std::size_t stride = twidth + 1;
+  int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+  while (true) {
+    frame_[(theight - 1 - y0) * stride + x0] = 'X';
+    if (x0 == x1 && y0 == y1)
+      return;
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+namespace {
+
+void append_number(std::string &s, int n) {
+  char buffer[16];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), n);
+  s.append(buffer, result.ptr);
+}
+
+// moves the cursor to _row_ and _column_, counted from 0
+void append_move(std::string &s, int row, int column) {
+  s += "\x1b[";
+  append_number(s, row + 1);
+  s += ';';
+  append_number(s, column + 1);
+  s += 'H';
+}
+
+// rewriting this many unchanged cells between two changed ones is cheaper
+// than moving the cursor over them
+constexpr int max_gap = 6;
+
+} // namespace
+
+void curve_print::write_changes() const {
+  patch_.clear();
+  std::size_t stride = twidth + 1;
+
+  if (shown_.size() != frame_.size()) {
+    // nothing or a different size is on screen, so clear and draw it all
+    patch_ += "\x1b[H\x1b[2J";
+    patch_ += frame_;
+  } else {
+    for (int row = 0; row < theight; row++) {
+      char const *now = frame_.data() + row * stride;
+      char const *before = shown_.data() + row * stride;
+      if (std::memcmp(now, before, twidth) == 0)
+        continue;
+
+      int column = 0;
+      while (column < twidth) {
+        if (now[column] == before[column]) {
+          column++;
+          continue;
+        }
+
+        // extend the run over changed cells and short unchanged gaps
+        int start = column, end = column + 1;
+        for (int c = end; c < twidth && c - end <= max_gap; c++) {
+          if (now[c] != before[c])
+            end = c + 1;
+        }
+        append_move(patch_, row, start);
+        patch_.append(now + start, now + end);
+        column = end;
+      }
+    }
+    append_move(patch_, theight, 0);
+  }
+
+  out.write(patch_.data(), static_cast<std::streamsize>(patch_.size()));
+  out.flush();
+  shown_ = frame_;
+}
@@ -0,0 +1,113 @@
+#include "rdp_batch.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct batch_range {
+  point const *points;
+  size_t const *offsets;
+  size_t first, last;
+  double epsilon;
+  size_t *kept_indices;
+  size_t *kept_offsets;
+  pthread_t thread;
+  bool started;
+};
+
+/*
+ * Simplifies the polylines [first, last) writing the kept indices of
+ * polyline i to kept_indices + offsets[i], which always has room because a
+ * polyline never keeps more points than it has, and the number kept to
+ * kept_offsets[i + 1].
+ */
+static void *batch_range_run(void *arg) {
+  struct batch_range *r = arg;
+
+  struct rdp_workspace ws;
+  rdp_workspace_init(&ws);
+
+  for (size_t i = r->first; i < r->last; i++) {
+    size_t begin = r->offsets[i];
+    curve polyline;
+    polyline.length = (int)(r->offsets[i + 1] - begin);
+    polyline.points = (point *)(r->points + begin);
+
+    int kept = rdp_indices(&polyline, r->epsilon, &ws);
+    for (int k = 0; k < kept; k++) {
+      r->kept_indices[begin + k] = begin + ws.indices[k];
+    }
+    r->kept_offsets[i + 1] = kept;
+  }
+
+  rdp_workspace_free(&ws);
+  return NULL;
+}
+
+size_t rdp_batch(point const *points, size_t const *offsets, size_t count,
+                 double epsilon, size_t *kept_indices, size_t *kept_offsets,
+                 int threads) {
+  if (threads < 1)
+    threads = 1;
+  if ((size_t)threads > count)
+    threads = count == 0 ? 1 : (int)count;
+
+  struct batch_range *ranges = malloc(sizeof(*ranges) * threads);
+  if (ranges == NULL) {
+    struct batch_range single = {.points = points,
+                                 .offsets = offsets,
+                                 .first = 0,
+                                 .last = count,
+                                 .epsilon = epsilon,
+                                 .kept_indices = kept_indices,
+                                 .kept_offsets = kept_offsets};
+    batch_range_run(&single);
+  } else {
+    // give each thread about the same number of points
+    size_t total = offsets[count] - offsets[0];
+    size_t first = 0;
+    for (int t = 0; t < threads; t++) {
+      size_t target = offsets[0] + total / threads * (t + 1);
+      size_t last = first;
+      if (t == threads - 1)
+        last = count;
+      else
+        while (last < count && offsets[last] < target)
+          last++;
+
+      ranges[t].points = points;
+      ranges[t].offsets = offsets;
+      ranges[t].first = first;
+      ranges[t].last = last;
+      ranges[t].epsilon = epsilon;
+      ranges[t].kept_indices = kept_indices;
+      ranges[t].kept_offsets = kept_offsets;
+      first = last;
+    }
+
+    // ranges that fail to start a thread run on this thread instead
+    for (int t = 1; t < threads; t++) {
+      ranges[t].started = pthread_create(&ranges[t].thread, NULL,
+                                         batch_range_run, &ranges[t]) == 0;
+    }
+    batch_range_run(&ranges[0]);
+    for (int t = 1; t < threads; t++) {
+      if (ranges[t].started)
+        pthread_join(ranges[t].thread, NULL);
+      else
+        batch_range_run(&ranges[t]);
+    }
+    free(ranges);
+  }
+
+  // each polyline's output only moves towards the front so the kept indices
+  // can be packed in place in one pass
+  kept_offsets[0] = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t kept = kept_offsets[i + 1];
+    memmove(kept_indices + kept_offsets[i], kept_indices + offsets[i],
+            sizeof(*kept_indices) * kept);
+    kept_offsets[i + 1] = kept_offsets[i] + kept;
+  }
+  return kept_offsets[count];
+}
@@ -0,0 +1,109 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace {
+
+// the pool and queue index of the current thread if it is a worker
+thread_local thread_pool const *current_pool = nullptr;
+thread_local unsigned current_index = 0;
+
+} // namespace
+
+thread_pool::thread_pool(unsigned threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (unsigned i = 0; i < threads; i++)
+    queues_.push_back(std::make_unique<worker_queue>());
+
+  for (unsigned i = 0; i < threads; i++)
+    workers_.emplace_back([this, i] { worker_loop(i); });
+}
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard guard(sleep_lock_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &w : workers_)
+    w.join();
+}
+
+void thread_pool::submit(std::function<void()> task) {
+  unsigned index = current_pool == this
+                       ? current_index
+                       : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                             queues_.size();
+  {
+    std::lock_guard guard(queues_[index]->lock);
+    queues_[index]->tasks.push_back(std::move(task));
+    queued_.fetch_add(1, std::memory_order_release);
+  }
+  {
+    // taking the lock orders this wake up after a worker's emptiness check
+    std::lock_guard guard(sleep_lock_);
+  }
+  wake_.notify_one();
+}
+
+bool thread_pool::pop_task(unsigned index, std::function<void()> &task) {
+  std::lock_guard guard(queues_[index]->lock);
+  auto &tasks = queues_[index]->tasks;
+  if (tasks.empty())
+    return false;
+  task = std::move(tasks.back());
+  tasks.pop_back();
+  queued_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool thread_pool::steal_task(unsigned thief, std::function<void()> &task) {
+  for (unsigned offset = 1; offset <= queues_.size(); offset++) {
+    unsigned victim = (thief + offset) % queues_.size();
+    std::lock_guard guard(queues_[victim]->lock);
+    auto &tasks = queues_[victim]->tasks;
+    if (tasks.empty())
+      continue;
+    task = std::move(tasks.front());
+    tasks.pop_front();
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+bool thread_pool::run_pending() {
+  if (queued_.load(std::memory_order_acquire) == 0)
+    return false;
+
+  std::function<void()> task;
+  bool found = current_pool == this ? pop_task(current_index, task) ||
+                                          steal_task(current_index, task)
+                                    : steal_task(0, task);
+  if (!found)
+    return false;
+  task();
+  return true;
+}
+
+void thread_pool::worker_loop(unsigned index) {
+  current_pool = this;
+  current_index = index;
+
+  std::function<void()> task;
+  while (true) {
+    if (pop_task(index, task) || steal_task(index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    std::unique_lock guard(sleep_lock_);
+    wake_.wait(guard, [this] {
+      return stopping_ || queued_.load(std::memory_order_acquire) != 0;
+    });
+    if (stopping_ && queued_.load(std::memory_order_acquire) == 0)
+      return;
+  }
+}